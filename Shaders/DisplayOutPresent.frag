@@ -0,0 +1,73 @@
+// Copyright MediaZ Teknoloji A.S. All Rights Reserved.
+#version 450
+
+layout(binding = 0) uniform sampler2D Input;
+
+layout(binding = 1) uniform PresentParams
+{
+	vec4 DestRect; // Placement of the input in the output, in output pixels: x, y, width, height
+	vec4 SourceRect; // Part of the input that is presented, in input pixels: x, y, width, height
+	uint ScaleMode; // 0: nearest, 1: bilinear, 2: integer
+	uint Dither;
+	uint Rotation; // Quarter turns, clockwise
+	uint Flip; // Bit 0: horizontal, bit 1: vertical, applied after the rotation
+} Params;
+
+layout(location = 0) out vec4 rt;
+
+float Hash(vec2 p)
+{
+	return fract(sin(dot(p, vec2(12.9898, 78.233))) * 43758.5453);
+}
+
+// Filtered in the shader so that the result does not depend on the sampler the input is bound with
+vec4 Bilinear(vec2 pos)
+{
+	ivec2 maxCoord = textureSize(Input, 0) - 1;
+	vec2 p = pos - 0.5;
+	ivec2 i = ivec2(floor(p));
+	vec2 f = p - vec2(i);
+	vec4 a = texelFetch(Input, clamp(i, ivec2(0), maxCoord), 0);
+	vec4 b = texelFetch(Input, clamp(i + ivec2(1, 0), ivec2(0), maxCoord), 0);
+	vec4 c = texelFetch(Input, clamp(i + ivec2(0, 1), ivec2(0), maxCoord), 0);
+	vec4 d = texelFetch(Input, clamp(i + ivec2(1, 1), ivec2(0), maxCoord), 0);
+	return mix(mix(a, b, f.x), mix(c, d, f.x), f.y);
+}
+
+void main()
+{
+	vec2 local = (gl_FragCoord.xy - Params.DestRect.xy) / Params.DestRect.zw;
+	if (any(lessThan(local, vec2(0))) || any(greaterThanEqual(local, vec2(1))))
+	{
+		rt = vec4(0, 0, 0, 1);
+		return;
+	}
+	// Output position to source position, undoing the flip and the rotation
+	if ((Params.Flip & 1u) != 0)
+		local.x = 1.0 - local.x;
+	if ((Params.Flip & 2u) != 0)
+		local.y = 1.0 - local.y;
+	vec2 st = local;
+	if (Params.Rotation == 1)
+		st = vec2(local.y, 1.0 - local.x);
+	else if (Params.Rotation == 2)
+		st = 1.0 - local;
+	else if (Params.Rotation == 3)
+		st = vec2(1.0 - local.y, local.x);
+	ivec2 size = textureSize(Input, 0);
+	vec2 pos = Params.SourceRect.xy + st * Params.SourceRect.zw;
+	// Source rects may reach past the input, e.g. a video wall larger than its canvas
+	if (any(lessThan(pos, vec2(0))) || any(greaterThanEqual(pos, vec2(size))))
+	{
+		rt = vec4(0, 0, 0, 1);
+		return;
+	}
+	vec4 color = Params.ScaleMode == 1 ? Bilinear(pos) : texelFetch(Input, min(ivec2(pos), size - 1), 0);
+	if (Params.Dither != 0)
+	{
+		// Triangular noise of one 8 bit step, hides banding when a higher precision input is quantized
+		float noise = Hash(gl_FragCoord.xy) + Hash(gl_FragCoord.xy + 17.0) - 1.0;
+		color.rgb += noise / 255.0;
+	}
+	rt = color;
+}
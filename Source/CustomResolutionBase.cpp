@@ -1,17 +1,31 @@
 #include "CustomResolutionBase.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <unordered_set>
+
 namespace nos::display
 {
 std::unique_ptr<CustomResolutionBase> CustomResolutionBase::Instance = nullptr;
 
+#if defined(WIN32)
 extern std::unique_ptr<CustomResolutionBase> TryCreateNVIDIACustomResolution();
-
+#elif defined(__linux)
+extern std::unique_ptr<CustomResolutionBase> TryCreateXRandRCustomResolution();
+#endif
 
 bool CustomResolutionBase::Create()
 {
+#if defined(WIN32)
 	Instance = TryCreateNVIDIACustomResolution();
+#elif defined(__linux)
+	Instance = TryCreateXRandRCustomResolution();
+#endif
 	if (!Instance)
 		return false;
+	// Backends constructed elsewhere, like the tests' mock, keep their cache in memory unless they load one
+	Instance->LoadTimingCache(TimingCache::GetDefaultPath());
 	return true;
 }
 
@@ -25,4 +39,393 @@ CustomResolutionBase* CustomResolutionBase::Get()
 	return Instance.get();
 }
 
-}
\ No newline at end of file
+void CustomResolutionBase::RefreshTopology(std::vector<WindowSystemMonitor> const& monitors)
+{
+	auto topology = std::make_shared<DisplayTopology>();
+	auto addEntry = [&](DisplayPortInfo const& display) {
+		topology->ByPort[display.Port] = topology->Entries.size();
+		topology->ByDisplayId[display.DisplayId] = topology->Entries.size();
+		topology->Entries.push_back({ .Port = display.Port, .DisplayId = display.DisplayId });
+	};
+	for (auto& display : EnumerateActiveDisplays())
+		addEntry(display);
+	for (auto& monitor : monitors)
+	{
+		auto displayId = GetDisplayIdFromAdapterName(monitor.AdapterName.c_str());
+		if (!displayId)
+			continue;
+		if (!topology->ByDisplayId.contains(*displayId))
+		{
+			auto port = GetPortFromDisplayId(*displayId);
+			if (!port)
+				continue;
+			addEntry({ .Port = *port, .DisplayId = *displayId });
+		}
+		size_t index = topology->ByDisplayId[*displayId];
+		auto& entry = topology->Entries[index];
+		entry.AdapterName = monitor.AdapterName;
+		entry.Monitor = monitor.Handle;
+		entry.MonitorName = monitor.Name;
+		topology->ByAdapterName[monitor.AdapterName] = index;
+		topology->ByMonitor[monitor.Handle] = index;
+	}
+	std::unordered_map<void*, uint32_t> busIds;
+	for (size_t i = 0; i < topology->Entries.size(); ++i)
+	{
+		auto& entry = topology->Entries[i];
+		auto busId = busIds.find(entry.Port.GPUId);
+		if (busId == busIds.end())
+			busId = busIds.emplace(entry.Port.GPUId, GetGPUBusId(entry.Port.GPUId).value_or(MonitorKey::AnyGPU)).first;
+		entry.Key = { .GPUBusId = busId->second, .PortId = entry.Port.PortId };
+		FormatMonitorLabel(entry.MonitorName.empty() ? "Unknown" : entry.MonitorName, entry.Key, entry.Label);
+		topology->ByKey[entry.Key] = i;
+	}
+	{
+		// A port may be driving another display after a hot-plug
+		std::unique_lock lock(CapabilitiesMutex);
+		Capabilities.clear();
+		EDIDHashes.clear();
+	}
+	std::unique_lock lock(TopologyMutex);
+	topology->Generation = ++TopologyGeneration;
+	Topology = std::move(topology);
+}
+
+namespace
+{
+// Why timing cannot be shown over the link of info or by the display, nothing if it can
+std::optional<std::string> CheckTiming(CustomResolutionInfo const& info, DisplayCapabilities const* capabilities, DisplayTiming const& timing)
+{
+	// Alpha is not sent over the link
+	uint32_t bitsPerPixel = info.ColorDepth % 3 ? info.ColorDepth * 3 / 4 : info.ColorDepth;
+	if (uint64_t maxPixelClock = GetMaxPixelClock(info.Link, bitsPerPixel); maxPixelClock && timing.PixelClock > maxPixelClock)
+	{
+		char reason[160];
+		std::snprintf(reason, sizeof(reason), "needs a %.2f MHz pixel clock, %s carries at most %.2f MHz at %u bits per pixel", timing.PixelClock / 1e6,
+					  DisplayLinkNames[uint32_t(info.Link)], maxPixelClock / 1e6, bitsPerPixel);
+		return reason;
+	}
+	if (capabilities)
+		return capabilities->Reject(timing, bitsPerPixel);
+	return std::nullopt;
+}
+
+TimingRequest ToTimingRequest(CustomResolutionInfo const& info)
+{
+	return { .Width = info.Resolution.x,
+			 .Height = info.Resolution.y,
+			 .RefreshRate = info.RefreshRate,
+			 .Standard = info.Standard,
+			 .Link = info.Link,
+			 .ColorDepth = info.ColorDepth };
+}
+
+void LogNativeMode(DisplayCapabilities const* capabilities)
+{
+	if (!capabilities)
+		return;
+	if (auto native = capabilities->GetNativeTiming())
+		nosEngine.LogI("Native mode of %s is %ux%u@%.3f", capabilities->MonitorName.empty() ? "the display" : capabilities->MonitorName.c_str(),
+					   native->HActive, native->VActive, native->RefreshRate());
+}
+}
+
+std::optional<DisplayTiming> CustomResolutionBase::FindCachedTiming(GPUPortIdentifier portId, CustomResolutionInfo const& info)
+{
+	if (auto key = GetCacheKey(portId))
+		return Cache.FindTiming(key->first, key->second, ToTimingRequest(info));
+	return std::nullopt;
+}
+
+void CustomResolutionBase::CacheTiming(GPUPortIdentifier portId, CustomResolutionInfo const& info, DisplayTiming const& timing)
+{
+	if (auto key = GetCacheKey(portId))
+		Cache.AddTiming(key->first, key->second, ToTimingRequest(info), timing);
+}
+
+std::optional<DisplayTiming> CustomResolutionBase::ResolveTiming(GPUPortIdentifier portId, CustomResolutionInfo const& info)
+{
+	// Resolved against the same EDID and link before, so it passed the same checks
+	if (auto cached = FindCachedTiming(portId, info))
+		return cached;
+	auto timing = ResolveUncachedTiming(portId, info);
+	if (timing)
+		CacheTiming(portId, info, *timing);
+	return timing;
+}
+
+std::optional<DisplayTiming> CustomResolutionBase::ResolveUncachedTiming(GPUPortIdentifier portId, CustomResolutionInfo const& info)
+{
+	auto capabilities = GetCapabilities(portId);
+	if (info.Standard == TimingStandard::Auto && capabilities)
+	{
+		// The display's own timings are known to work, whatever their blanking
+		for (auto& timing : capabilities->DetailedTimings)
+			if (timing.HActive == info.Resolution.x && timing.VActive == info.Resolution.y && std::abs(timing.RefreshRate() - info.RefreshRate) < 0.01 &&
+				!CheckTiming(info, capabilities.get(), timing))
+				return timing;
+		std::optional<DisplayTiming> cheapest;
+		for (auto standard : { TimingStandard::CVTReducedBlankingV2, TimingStandard::CVTReducedBlanking, TimingStandard::CVT, TimingStandard::GTF })
+		{
+			auto timing = ComputeTiming(standard, info.Resolution.x, info.Resolution.y, info.RefreshRate);
+			if (timing && !CheckTiming(info, capabilities.get(), *timing) && (!cheapest || timing->PixelClock < cheapest->PixelClock))
+				cheapest = timing;
+		}
+		if (cheapest)
+			return cheapest;
+		// None fits, the reduced blanking v2 timing is reported below
+	}
+	auto timing = ComputeTiming(info.Standard, info.Resolution.x, info.Resolution.y, info.RefreshRate);
+	if (!timing)
+	{
+		nosEngine.LogE("No %s timing for %ux%u@%.3f", TimingStandardNames[uint32_t(info.Standard)], info.Resolution.x, info.Resolution.y, info.RefreshRate);
+		LogNativeMode(capabilities.get());
+		return std::nullopt;
+	}
+	if (!ValidateTiming(portId, info, *timing))
+		return std::nullopt;
+	return timing;
+}
+
+bool CustomResolutionBase::ValidateTiming(GPUPortIdentifier portId, CustomResolutionInfo const& info, DisplayTiming const& timing)
+{
+	auto capabilities = GetCapabilities(portId);
+	auto reason = CheckTiming(info, capabilities.get(), timing);
+	if (!reason)
+		return true;
+	nosEngine.LogE("%ux%u@%.3f cannot be shown: %s", timing.HActive, timing.VActive, timing.RefreshRate(), reason->c_str());
+	LogNativeMode(capabilities.get());
+	return false;
+}
+
+bool CustomResolutionBase::SetResolutionsAndRefreshRates(std::vector<CustomResolutionRequest> const& requests)
+{
+	std::unordered_set<GPUPortIdentifier, GPUPortIdentifierHash> ports;
+	for (auto& request : requests)
+	{
+		if (ports.insert(request.Port).second)
+			continue;
+		nosEngine.LogE("Port %u is set more than once in one transaction", request.Port.PortId);
+		return false;
+	}
+	if (requests.empty())
+		return true;
+	std::unique_lock lock(TransactionMutex);
+	// Displays an earlier run left in the requested mode are not switched, they would only blank and resync
+	std::vector<CustomResolutionRequest> pending;
+	for (auto& request : requests)
+	{
+		if (!IsRunningCachedMode(request))
+			pending.push_back(request);
+		else
+			nosEngine.LogI("Display on port %u already runs %ux%u@%.3f", request.Port.PortId, request.Info.Resolution.x, request.Info.Resolution.y,
+						   request.Info.RefreshRate);
+	}
+	if (!pending.empty() && !ApplyModes(pending))
+	{
+		std::vector<GPUPortIdentifier> pendingPorts;
+		for (auto& request : pending)
+			pendingPorts.push_back(request.Port);
+		RollBack(pendingPorts);
+		return false;
+	}
+	for (auto& request : pending)
+	{
+		AdoptedModes.erase(request.Port);
+		AppliedModes[request.Port] = request.Info;
+	}
+	// The backend never switched the skipped displays and cannot know what they ran before the earlier run
+	for (auto& request : requests)
+	{
+		if (auto it = AppliedModes.find(request.Port); it != AppliedModes.end())
+			it->second = request.Info;
+		else
+			AdoptedModes[request.Port] = request.Info;
+	}
+	// What the display ended up running is recorded, not what was asked for, drivers may round the timing
+	for (auto& request : pending)
+		if (auto key = GetCacheKey(request.Port))
+			if (auto current = GetCurrentTiming(request.Port))
+				Cache.SetAppliedMode(key->first, key->second, ToTimingRequest(request.Info), *current);
+	return true;
+}
+
+bool CustomResolutionBase::IsRunningCachedMode(CustomResolutionRequest const& request)
+{
+	auto key = GetCacheKey(request.Port);
+	if (!key)
+		return false;
+	auto applied = Cache.FindAppliedMode(key->first, key->second);
+	if (!applied || applied->Request != ToTimingRequest(request.Info))
+		return false;
+	// The entry is stale if anything changed the mode since, e.g. a revert on shutdown or a driver reset
+	auto current = GetCurrentTiming(request.Port);
+	return current && IsSameMode(*current, applied->Timing);
+}
+
+std::optional<std::pair<MonitorKey, uint64_t>> CustomResolutionBase::GetCacheKey(GPUPortIdentifier portId)
+{
+	auto topology = GetTopology();
+	auto entry = topology->FindByPort(portId);
+	if (!entry)
+		return std::nullopt;
+	// Reads the EDID once per port
+	GetCapabilities(portId);
+	std::unique_lock lock(CapabilitiesMutex);
+	if (auto it = EDIDHashes.find(portId); it != EDIDHashes.end())
+		return std::pair{ entry->Key, it->second };
+	return std::nullopt;
+}
+
+bool CustomResolutionBase::RevertResolutions(std::vector<GPUPortIdentifier> const& portIds)
+{
+	std::unique_lock lock(TransactionMutex);
+	bool reverted = true;
+	std::vector<GPUPortIdentifier> applied;
+	for (auto& port : portIds)
+	{
+		// The entry stays, every later revert is refused the same way
+		if (AdoptedModes.contains(port))
+		{
+			nosEngine.LogW("Display on port %u keeps the mode an earlier run left on it, its original mode is unknown", port.PortId);
+			reverted = false;
+		}
+		else if (AppliedModes.contains(port) && std::find(applied.begin(), applied.end(), port) == applied.end())
+			applied.push_back(port);
+	}
+	if (applied.empty())
+		return reverted;
+	if (RevertModes(applied))
+	{
+		auto topology = GetTopology();
+		for (auto& port : applied)
+		{
+			AppliedModes.erase(port);
+			if (auto entry = topology->FindByPort(port))
+				Cache.ClearAppliedMode(entry->Key);
+		}
+		return reverted;
+	}
+	RollBack(applied);
+	return false;
+}
+
+void CustomResolutionBase::RollBack(std::vector<GPUPortIdentifier> const& portIds)
+{
+	std::vector<GPUPortIdentifier> revert;
+	std::vector<CustomResolutionRequest> reapply;
+	for (auto& port : portIds)
+	{
+		if (auto it = AppliedModes.find(port); it != AppliedModes.end())
+			reapply.push_back({ .Port = port, .Info = it->second });
+		else
+			revert.push_back(port);
+	}
+	if (!revert.empty() && !RevertModes(revert))
+		nosEngine.LogE("Failed to roll back %zu display(s) to their original modes", revert.size());
+	if (reapply.empty() || ApplyModes(reapply))
+		return;
+	// Their custom modes are lost, the original ones are the only known state left
+	nosEngine.LogE("Failed to restore the custom modes of %zu display(s), reverting them", reapply.size());
+	auto topology = GetTopology();
+	std::vector<GPUPortIdentifier> lost;
+	for (auto& request : reapply)
+	{
+		lost.push_back(request.Port);
+		AppliedModes.erase(request.Port);
+		if (auto entry = topology->FindByPort(request.Port))
+			Cache.ClearAppliedMode(entry->Key);
+	}
+	RevertModes(lost);
+}
+
+std::optional<CustomResolutionInfo> CustomResolutionBase::GetAppliedResolution(GPUPortIdentifier portId) const
+{
+	std::unique_lock lock(TransactionMutex);
+	if (auto it = AppliedModes.find(portId); it != AppliedModes.end())
+		return it->second;
+	if (auto it = AdoptedModes.find(portId); it != AdoptedModes.end())
+		return it->second;
+	return std::nullopt;
+}
+
+std::shared_ptr<const DisplayCapabilities> CustomResolutionBase::GetCapabilities(GPUPortIdentifier portId)
+{
+	{
+		std::unique_lock lock(CapabilitiesMutex);
+		if (auto it = Capabilities.find(portId); it != Capabilities.end())
+			return it->second;
+	}
+	// Read without the lock, backends lock their own state to talk to the driver
+	std::shared_ptr<const DisplayCapabilities> capabilities;
+	std::optional<uint64_t> edidHash;
+	if (auto edid = ReadEDID(portId))
+	{
+		if (auto parsed = ParseEDID(*edid))
+		{
+			capabilities = std::make_shared<const DisplayCapabilities>(std::move(*parsed));
+			edidHash = HashEDID(*edid);
+		}
+		else
+			nosEngine.LogW("Invalid EDID on port %u, display capabilities are unknown", portId.PortId);
+	}
+	// Cached entries of another display on the port are stale, comparing the hash is all it takes to tell
+	auto topology = GetTopology();
+	if (auto entry = topology->FindByPort(portId); entry && edidHash && !Cache.UpdateDisplay(entry->Key, *edidHash, capabilities->MonitorName))
+		nosEngine.LogI("%s is not the display seen there before, its cached timings are dropped", entry->Label.data());
+	std::unique_lock lock(CapabilitiesMutex);
+	if (edidHash)
+		EDIDHashes[portId] = *edidHash;
+	return Capabilities.emplace(portId, std::move(capabilities)).first->second;
+}
+
+const DisplayTopologyEntry* DisplayTopology::FindByKey(MonitorKey key) const
+{
+	if (key.GPUBusId != MonitorKey::AnyGPU)
+		return Find(ByKey, key);
+	// Port only key, resolve if the port id is unambiguous
+	const DisplayTopologyEntry* found = nullptr;
+	for (auto& entry : Entries)
+	{
+		if (entry.Port.PortId != key.PortId)
+			continue;
+		if (found)
+			return nullptr;
+		found = &entry;
+	}
+	return found;
+}
+
+std::shared_ptr<const DisplayTopology> CustomResolutionBase::GetTopology() const
+{
+	std::unique_lock lock(TopologyMutex);
+	return Topology;
+}
+
+std::optional<std::string> CustomResolutionBase::GetAdapterName(GPUPortIdentifier portId) const
+{
+	auto topology = GetTopology();
+	if (auto entry = topology->FindByPort(portId); entry && !entry->AdapterName.empty())
+		return entry->AdapterName;
+	return std::nullopt;
+}
+
+std::optional<GPUPortIdentifier> CustomResolutionBase::GetGPUPortIdFromAdapterName(const char* adapterName) const
+{
+	auto topology = GetTopology();
+	if (auto entry = topology->FindByAdapterName(adapterName))
+		return entry->Port;
+	return std::nullopt;
+}
+
+std::vector<GPUPortIdentifier> CustomResolutionBase::GetActivePortIds() const
+{
+	auto topology = GetTopology();
+	std::vector<GPUPortIdentifier> ports;
+	ports.reserve(topology->Entries.size());
+	for (auto& entry : topology->Entries)
+		ports.push_back(entry.Port);
+	return ports;
+}
+
+}
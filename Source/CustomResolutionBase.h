@@ -3,6 +3,15 @@
 #include <Nodos/PluginHelpers.hpp>
 #include <nosVulkanSubsystem/nosVulkanSubsystem.h>
 
+#include "DisplayTiming.h"
+#include "EDID.h"
+#include "MonitorKey.h"
+#include "TimingCache.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
 namespace nos::display
 {
 struct CustomResolutionInfo
@@ -11,6 +20,8 @@ struct CustomResolutionInfo
 	float RefreshRate;
 	uint32_t ColorDepth = 32;
 	nosFormat ColorFormat = NOS_FORMAT_B8G8R8A8_UNORM;
+	TimingStandard Standard = TimingStandard::Auto;
+	DisplayLink Link = DisplayLink::Unknown; // Bounds the pixel clock, unchecked if unknown
 };
 
 struct GPUPortIdentifier
@@ -20,6 +31,73 @@ struct GPUPortIdentifier
 	auto operator<=>(const GPUPortIdentifier&) const = default;
 };
 
+struct GPUPortIdentifierHash
+{
+	size_t operator()(GPUPortIdentifier const& port) const
+	{
+		return std::hash<void*>()(port.GPUId) ^ (std::hash<uint32_t>()(port.PortId) << 1);
+	}
+};
+
+// One port's part of a custom resolution transaction
+struct CustomResolutionRequest
+{
+	GPUPortIdentifier Port{};
+	CustomResolutionInfo Info{};
+};
+
+// A display as reported by the custom resolution backend
+struct DisplayPortInfo
+{
+	GPUPortIdentifier Port;
+	uint32_t DisplayId = 0;
+};
+
+// A monitor as reported by the window system (GLFW)
+struct WindowSystemMonitor
+{
+	std::string AdapterName;
+	void* Handle = nullptr;
+	std::string Name;
+};
+
+struct DisplayTopologyEntry
+{
+	GPUPortIdentifier Port{};
+	uint32_t DisplayId = 0;
+	std::string AdapterName;
+	void* Monitor = nullptr; // GLFWmonitor*, null if the port is not visible to the window system
+	std::string MonitorName;
+	MonitorKey Key;
+	MonitorLabel Label{};
+};
+
+// Immutable snapshot of the adapter name / monitor / port / display id mapping.
+struct DisplayTopology
+{
+	const DisplayTopologyEntry* FindByPort(GPUPortIdentifier port) const { return Find(ByPort, port); }
+	const DisplayTopologyEntry* FindByAdapterName(std::string const& adapterName) const { return Find(ByAdapterName, adapterName); }
+	const DisplayTopologyEntry* FindByMonitor(void* monitor) const { return Find(ByMonitor, monitor); }
+	const DisplayTopologyEntry* FindByDisplayId(uint32_t displayId) const { return Find(ByDisplayId, displayId); }
+	const DisplayTopologyEntry* FindByKey(MonitorKey key) const;
+
+	uint64_t Generation = 0;
+	std::vector<DisplayTopologyEntry> Entries;
+	std::unordered_map<GPUPortIdentifier, size_t, GPUPortIdentifierHash> ByPort;
+	std::unordered_map<std::string, size_t> ByAdapterName;
+	std::unordered_map<void*, size_t> ByMonitor;
+	std::unordered_map<uint32_t, size_t> ByDisplayId;
+	std::unordered_map<MonitorKey, size_t, MonitorKeyHash> ByKey;
+
+private:
+	template <typename Map, typename Key>
+	const DisplayTopologyEntry* Find(Map const& map, Key const& key) const
+	{
+		auto it = map.find(key);
+		return it == map.end() ? nullptr : &Entries[it->second];
+	}
+};
+
 struct CustomResolutionBase
 {
 	virtual ~CustomResolutionBase() = default;
@@ -27,14 +105,92 @@ struct CustomResolutionBase
 	static void Destroy();
 	virtual bool Init() = 0;
 	virtual void Shutdown() = 0;
-	virtual bool SetResolutionAndRefreshRate(GPUPortIdentifier portId, CustomResolutionInfo info) = 0;
-	virtual bool RevertResolution(GPUPortIdentifier portId) = 0;
-	virtual std::optional<std::string> GetAdapterName(GPUPortIdentifier portId, std::vector<std::string> const& possibleAdapterNames) = 0;
-	virtual std::vector<GPUPortIdentifier> GetActivePortIds() = 0;
-	virtual std::optional<GPUPortIdentifier> GetGPUPortIdFromAdapterName(const char* adapterName) = 0;
+
+	// Sets the modes of all ports in one go where the backend can, so that a wall of panels resyncs once. All or nothing:
+	// when a port fails, every port of the request goes back to the mode it ran before the call.
+	bool SetResolutionsAndRefreshRates(std::vector<CustomResolutionRequest> const& requests);
+	// Puts ports back to the modes they ran before their first custom mode, all or nothing as well.
+	// Ports without a custom mode are left alone. Ports left in their mode by an earlier run cannot be reverted, they keep
+	// it and every call for them returns false until they are set to another mode.
+	bool RevertResolutions(std::vector<GPUPortIdentifier> const& portIds);
+	bool SetResolutionAndRefreshRate(GPUPortIdentifier portId, CustomResolutionInfo info) { return SetResolutionsAndRefreshRates({ { portId, info } }); }
+	bool RevertResolution(GPUPortIdentifier portId) { return RevertResolutions({ portId }); }
+	// Custom mode last set on portId, nothing if it runs its original mode
+	std::optional<CustomResolutionInfo> GetAppliedResolution(GPUPortIdentifier portId) const;
+
+	// Topology cache. Only rebuilt by RefreshTopology, which should be called on monitor hot-plug or on explicit refresh.
+	void RefreshTopology(std::vector<WindowSystemMonitor> const& monitors);
+	std::shared_ptr<const DisplayTopology> GetTopology() const;
+	uint64_t GetTopologyGeneration() const { return TopologyGeneration; }
+
+	std::optional<std::string> GetAdapterName(GPUPortIdentifier portId) const;
+	std::optional<GPUPortIdentifier> GetGPUPortIdFromAdapterName(const char* adapterName) const;
+	std::vector<GPUPortIdentifier> GetActivePortIds() const;
+
+	// Parsed EDID of the display on portId, read once per port and dropped by RefreshTopology. Null if the backend
+	// cannot read the EDID or it is invalid.
+	std::shared_ptr<const DisplayCapabilities> GetCapabilities(GPUPortIdentifier portId);
 
 	static CustomResolutionBase* Get();
+protected:
+	// Reads the cache earlier runs left at path and keeps writing it there, see TimingCache::Load
+	void LoadTimingCache(std::filesystem::path path) { Cache.Load(std::move(path)); }
+
+	// Timing resolved for info on portId by this or an earlier run, kept in the on-disk cache. Nothing if the display on
+	// portId has no EDID, as a changed display could not be told apart.
+	std::optional<DisplayTiming> FindCachedTiming(GPUPortIdentifier portId, CustomResolutionInfo const& info);
+	void CacheTiming(GPUPortIdentifier portId, CustomResolutionInfo const& info, DisplayTiming const& timing);
+
+	// Timing of info.Standard that the link and, when its EDID is known, the display on portId can take. Auto picks an
+	// advertised timing of the display if one matches, the lowest pixel clock of the standards otherwise.
+	// Logs the reason and the native mode of the display on failure.
+	std::optional<DisplayTiming> ResolveTiming(GPUPortIdentifier portId, CustomResolutionInfo const& info);
+	// Checks timing against the link and the display on portId, logs the reason if it cannot be shown
+	bool ValidateTiming(GPUPortIdentifier portId, CustomResolutionInfo const& info, DisplayTiming const& timing);
+
+	// Raw EDID with its extension blocks, nothing if the display does not provide one
+	virtual std::optional<std::vector<uint8_t>> ReadEDID(GPUPortIdentifier portId) = 0;
+
+	// Backend side of the transactions. ApplyModes may leave some of the ports changed when it fails, they are rolled back
+	// by the caller. RevertModes puts ports back to the modes they ran before the backend first changed them.
+	virtual bool ApplyModes(std::vector<CustomResolutionRequest> const& requests) = 0;
+	virtual bool RevertModes(std::vector<GPUPortIdentifier> const& portIds) = 0;
+	// Timing the display on portId runs now, whoever set it
+	virtual std::optional<DisplayTiming> GetCurrentTiming(GPUPortIdentifier portId) = 0;
+
+	// Backend queries used to build the topology
+	virtual std::vector<DisplayPortInfo> EnumerateActiveDisplays() = 0;
+	virtual std::optional<uint32_t> GetDisplayIdFromAdapterName(const char* adapterName) = 0;
+	virtual std::optional<GPUPortIdentifier> GetPortFromDisplayId(uint32_t displayId) = 0;
+	virtual std::optional<uint32_t> GetGPUBusId(void* gpuId) = 0;
+
 private:
+	// Cache key of the display on portId: its stable port key and EDID hash
+	std::optional<std::pair<MonitorKey, uint64_t>> GetCacheKey(GPUPortIdentifier portId);
+	// Whether the display already runs the mode an earlier run left on it for request, in which case it is not switched again
+	bool IsRunningCachedMode(CustomResolutionRequest const& request);
+
+	std::optional<DisplayTiming> ResolveUncachedTiming(GPUPortIdentifier portId, CustomResolutionInfo const& info);
+
+	// Brings ports back to the state AppliedModes records for them after a failed transaction
+	void RollBack(std::vector<GPUPortIdentifier> const& portIds);
+
 	static std::unique_ptr<CustomResolutionBase> Instance;
+
+	mutable std::mutex TransactionMutex;
+	std::unordered_map<GPUPortIdentifier, CustomResolutionInfo, GPUPortIdentifierHash> AppliedModes;
+	// Ports not switched because an earlier run left them in the requested mode. Not revertible, the backend never
+	// learned their original mode.
+	std::unordered_map<GPUPortIdentifier, CustomResolutionInfo, GPUPortIdentifierHash> AdoptedModes;
+
+	mutable std::mutex TopologyMutex;
+	std::shared_ptr<const DisplayTopology> Topology = std::make_shared<DisplayTopology>();
+	std::atomic<uint64_t> TopologyGeneration = 0;
+
+	std::mutex CapabilitiesMutex;
+	std::unordered_map<GPUPortIdentifier, std::shared_ptr<const DisplayCapabilities>, GPUPortIdentifierHash> Capabilities;
+	std::unordered_map<GPUPortIdentifier, uint64_t, GPUPortIdentifierHash> EDIDHashes;
+
+	TimingCache Cache;
 };
-}
\ No newline at end of file
+}
@@ -8,6 +8,7 @@
 #include <nosVulkanSubsystem/nosVulkanSubsystem.h>
 
 #include "CustomResolutionBase.h"
+#include "PresentPass.h"
 
 NOS_INIT_WITH_MIN_REQUIRED_MINOR(13)
 NOS_VULKAN_INIT()
@@ -22,17 +23,24 @@ namespace nos::display
 	enum Nodes : int
 	{	// CPU nodes
 		DisplayOut,
+		DisplayOutMulti,
 		Count
 	};
 
 	nosResult RegisterDisplayOut(nosNodeFunctions*);
+	nosResult RegisterDisplayOutMulti(nosNodeFunctions*);
 
 	struct DisplayPluginFunctions : nos::PluginFunctions
 	{
 		nosResult Initialize() override
 		{
-			if (!CustomResolutionBase::Create() || CustomResolutionBase::Get()->Init())
+			if (CustomResolutionBase::Create() && !CustomResolutionBase::Get()->Init())
+				CustomResolutionBase::Destroy();
+			if (!CustomResolutionBase::Get())
 				nosEngine.LogW("Failed to initialize CustomResolution!");
+			if (RegisterPresentPass() != NOS_RESULT_SUCCESS)
+				nosEngine.LogW("Failed to register the present pass, DisplayOut and DisplayOutMulti will stretch their inputs over the outputs, "
+							   "scale modes, letterbox, crop, rotation, flips and offsets are disabled");
 			return NOS_RESULT_SUCCESS;
 		}
 		nosResult OnPreUnloadPlugin() override
@@ -65,6 +73,7 @@ namespace nos::display
 				default:
 					break;
 					GEN_CASE_NODE(DisplayOut)
+					GEN_CASE_NODE(DisplayOutMulti)
 				}
 			}
 			return NOS_RESULT_SUCCESS;
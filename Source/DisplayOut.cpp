@@ -1,8 +1,19 @@
 #include "CustomResolutionBase.h"
+#include "FramePacer.h"
+#include "FrameStats.h"
+#include "InputQueue.h"
+#include "PresentBackend.h"
+#include "PresentPass.h"
+#include "PresentSwapchain.h"
+#include "ScheduleTimer.h"
+#include "WindowRuntime.h"
 
 #include <Nodos/PluginHelpers.hpp>
 #include <nosVulkanSubsystem/Helpers.hpp>
 
+#include <algorithm>
+#include <format>
+
 #include "nosUtil/Stopwatch.hpp"
 #include "GLFW/glfw3.h"
 #if defined(WIN32)
@@ -18,29 +29,6 @@
 namespace nos::display
 {
 
-std::vector<std::string> GetPossibleAdapterNames()
-{
-	std::vector<std::string> adapterNames;
-	int monitorCount;
-	GLFWmonitor** monitors = glfwGetMonitors(&monitorCount);
-	for (int i = 0; i < monitorCount; i++)
-		adapterNames.push_back(glfwGetWin32Adapter(monitors[i]));
-	return adapterNames;
-}
-
-GLFWmonitor* GetGLFWMonitorFromAdapterName(const char* adapterName)
-{
-	int monitorCount;
-	GLFWmonitor** monitors = glfwGetMonitors(&monitorCount);
-	for (int i = 0; i < monitorCount; i++)
-	{
-		const char* name = glfwGetWin32Adapter(monitors[i]);
-		if (strcmp(name, adapterName) == 0)
-			return monitors[i];
-	}
-	return nullptr;
-}
-
 GLFWmonitor* get_current_monitor(GLFWwindow* window)
 {
 	int nmonitors, i;
@@ -77,20 +65,16 @@ GLFWmonitor* get_current_monitor(GLFWwindow* window)
 	return bestmonitor;
 }
 
-GLFWmonitor* GetMonitorFromName(const char* monitorName)
+NOS_REGISTER_NAME(Monitor)
+
+enum class AcquireTimeoutPolicy
 {
-	int monitorCount;
-	GLFWmonitor** monitors = glfwGetMonitors(&monitorCount);
-	for (int i = 0; i < monitorCount; i++)
-	{
-		const char* name = glfwGetWin32Adapter(monitors[i]);
-		if (strcmp(name, monitorName) == 0)
-			return monitors[i];
-	}
-	return nullptr;
-}
+	Skip,	 // Drop the frame
+	Retry,	 // Present the same input on the next schedule
+	Recreate // Recreate the swapchain
+};
 
-NOS_REGISTER_NAME(Monitor)
+inline constexpr std::string_view AcquireTimeoutPolicyNames[] = { "Skip", "Retry", "Recreate" };
 
 struct DisplayOutNode : NodeContext
 {
@@ -101,6 +85,46 @@ struct DisplayOutNode : NodeContext
 		visualizer.name = std::string("Monitor_") + UUID2STR(NodeId);
 		SetPinVisualizer(NSN_Monitor, visualizer);
 		UpdateStringList(std::string("Monitor_") + UUID2STR(NodeId), {"NONE"});
+		fb::TVisualizer presentModeVisualizer;
+		presentModeVisualizer.type = fb::VisualizerType::COMBO_BOX;
+		presentModeVisualizer.name = "nos.display.PresentMode";
+		SetPinVisualizer(NOS_NAME_STATIC("PresentMode"), presentModeVisualizer);
+		std::vector<std::string> presentModes;
+		for (auto& info : LatencyOrderedPresentModes)
+			presentModes.push_back(info.Name);
+		UpdateStringList(presentModeVisualizer.name, presentModes);
+		fb::TVisualizer scaleModeVisualizer;
+		scaleModeVisualizer.type = fb::VisualizerType::COMBO_BOX;
+		scaleModeVisualizer.name = "nos.display.ScaleMode";
+		SetPinVisualizer(NOS_NAME_STATIC("ScaleMode"), scaleModeVisualizer);
+		UpdateStringList(scaleModeVisualizer.name, { std::begin(PresentScaleModeNames), std::end(PresentScaleModeNames) });
+		fb::TVisualizer rotationVisualizer;
+		rotationVisualizer.type = fb::VisualizerType::COMBO_BOX;
+		rotationVisualizer.name = "nos.display.Rotation";
+		SetPinVisualizer(NOS_NAME_STATIC("Rotation"), rotationVisualizer);
+		UpdateStringList(rotationVisualizer.name, { std::begin(PresentRotationNames), std::end(PresentRotationNames) });
+		fb::TVisualizer timingStandardVisualizer;
+		timingStandardVisualizer.type = fb::VisualizerType::COMBO_BOX;
+		timingStandardVisualizer.name = "nos.display.TimingStandard";
+		SetPinVisualizer(NOS_NAME_STATIC("TimingStandard"), timingStandardVisualizer);
+		UpdateStringList(timingStandardVisualizer.name, { std::begin(TimingStandardNames), std::end(TimingStandardNames) });
+		fb::TVisualizer linkVisualizer;
+		linkVisualizer.type = fb::VisualizerType::COMBO_BOX;
+		linkVisualizer.name = "nos.display.Link";
+		SetPinVisualizer(NOS_NAME_STATIC("Link"), linkVisualizer);
+		UpdateStringList(linkVisualizer.name, { std::begin(DisplayLinkNames), std::end(DisplayLinkNames) });
+		fb::TVisualizer inputPolicyVisualizer;
+		inputPolicyVisualizer.type = fb::VisualizerType::COMBO_BOX;
+		inputPolicyVisualizer.name = "nos.display.InputPolicy";
+		SetPinVisualizer(NOS_NAME_STATIC("InputPolicy"), inputPolicyVisualizer);
+		UpdateStringList(inputPolicyVisualizer.name, { std::begin(InputPolicyNames), std::end(InputPolicyNames) });
+		fb::TVisualizer timeoutPolicyVisualizer;
+		timeoutPolicyVisualizer.type = fb::VisualizerType::COMBO_BOX;
+		timeoutPolicyVisualizer.name = "nos.display.AcquireTimeoutPolicy";
+		SetPinVisualizer(NOS_NAME_STATIC("AcquireTimeoutPolicy"), timeoutPolicyVisualizer);
+		UpdateStringList(timeoutPolicyVisualizer.name, { std::begin(AcquireTimeoutPolicyNames), std::end(AcquireTimeoutPolicyNames) });
+		Pacer.SetTargetRate(RefreshRate);
+		HeartbeatPacer.SetTargetRate(HiddenHeartbeatRate);
 	}
 
 	~DisplayOutNode()
@@ -110,30 +134,28 @@ struct DisplayOutNode : NodeContext
 
 	bool CreateSwapchain()
 	{
-		nosSwapchainCreateInfo createInfo = {};
-		createInfo.SurfaceHandle = Surface;
 		// get extent
-		int width, height;
-		glfwGetWindowSize(Window, &width, &height);
-		createInfo.Extent = { uint32_t(width), uint32_t(height) };
-		createInfo.PresentMode = VSync ? NOS_PRESENT_MODE_FIFO : NOS_PRESENT_MODE_IMMEDIATE;
-		nosResult res = nosVulkan->CreateSwapchain(&createInfo, &Swapchain, &FrameCount);
-		if (res != NOS_RESULT_SUCCESS)
+		nosVec2u extent = Resolution;
+		if (Window)
+		{
+			extent = Runtime->Invoke([window = Window] {
+				int width, height;
+				glfwGetWindowSize(window, &width, &height);
+				return nosVec2u{ uint32_t(width), uint32_t(height) };
+			});
+		}
+		auto createdMode = Swapchain.Create(*Backend, extent, PresentMode, MaxFramesInFlight, true);
+		if (!createdMode)
 			return false;
-		nosSemaphoreCreateInfo semaphoreCreateInfo = {};
-		semaphoreCreateInfo.Type = NOS_SEMAPHORE_TYPE_BINARY;
-		Images.resize(FrameCount);
-		nosVulkan->GetSwapchainImages(Swapchain, Images.data());
-		WaitSemaphore.resize(FrameCount);
-		SignalSemaphore.resize(FrameCount);
-		for (int i = 0; i < FrameCount; i++)
-		{
-#ifdef CreateSemaphore
-#undef CreateSemaphore
-#endif
-			nosVulkan->CreateSemaphore(&semaphoreCreateInfo, &WaitSemaphore[i]);
-			nosVulkan->CreateSemaphore(&semaphoreCreateInfo, &SignalSemaphore[i]);
+		if (*createdMode != PresentMode)
+			nosEngine.LogW("%s: Present mode %s is not supported, using %s", GetWindowName().c_str(), GetPresentModeName(PresentMode), GetPresentModeName(*createdMode));
+		if (createdMode != ActivePresentMode)
+		{
+			ActivePresentMode = createdMode;
+			SetPinValue(NOS_NAME_STATIC("ActivePresentMode"), GetPresentModeName(*createdMode));
 		}
+		CurrentFrame = 0;
+		SwapchainNeedsFrame = true;
 		return true;
 	}
 
@@ -144,64 +166,89 @@ struct DisplayOutNode : NodeContext
 		DestroySwapchain();
 		DestroyWindowSurface();
 		DestroyWindow();
+		Backend.reset();
+		Runtime.reset();
+		Inputs.Clear();
+		if (Timer)
+			Timer->Cancel(NodeId);
+		Timer.reset();
 	}
 
 	bool TryCreateSwapchain()
 	{
-		if (Swapchain)
-			DestroySwapchain();
-		if (!Surface)
+		if (!Backend)
+			return false;
+		SwapchainDirty = false;
+		util::Stopwatch watch;
+		if (Backend->HasSwapchain())
+			RetireSwapchain();
+		// Upstream must not render into the images of the old swapchain, the next frame acquires and publishes a new one
+		if (RenderTargetPublished)
+			PublishRenderTarget(std::nullopt);
+		if (!Backend->HasSurface())
 			return false;
 		if (!CreateSwapchain())
 		{
+			DestroySwapchain();
 			DestroyWindowSurface();
 			DestroyWindow();
 			return false;
 		}
+		StageStats.Add(PresentStage::SwapchainRecreate, std::chrono::duration_cast<std::chrono::nanoseconds>(watch.Elapsed()));
 		return true;
 	}
 
+	// Used on teardown, drains the queue so that every retired resource can be released.
 	void DestroySwapchain()
 	{
-		if (!Swapchain)
+		if (!Backend)
 			return;
-		nosCmd cmd;
-		nosCmdBeginParams beginParams = { .Name = NOS_NAME("Window node flush cmd"), .AssociatedNodeId = NodeId, .OutCmdHandle = &cmd };
-		nosVulkan->Begin2(&beginParams);
-		nosGPUEvent wait;
-		nosCmdEndParams endParams = { .ForceSubmit = true, .OutGPUEventHandle = &wait };
-		nosVulkan->End(cmd, &endParams);
-		nosVulkan->WaitGpuEvent(&wait, UINT64_MAX);
-		for (int i = 0; i < FrameCount; i++)
+		if (!Backend->IsHeadless() && (Backend->HasSwapchain() || Swapchain.HasRetired()))
 		{
-			nosVulkan->DestroySemaphore(&WaitSemaphore[i]);
-			nosVulkan->DestroySemaphore(&SignalSemaphore[i]);
+			nosCmd cmd;
+			nosCmdBeginParams beginParams = { .Name = NOS_NAME("Window node flush cmd"), .AssociatedNodeId = NodeId, .OutCmdHandle = &cmd };
+			nosVulkan->Begin2(&beginParams);
+			nosGPUEvent wait;
+			nosCmdEndParams endParams = { .ForceSubmit = true, .OutGPUEventHandle = &wait };
+			nosVulkan->End(cmd, &endParams);
+			nosVulkan->WaitGpuEvent(&wait, UINT64_MAX);
 		}
-		WaitSemaphore.clear();
-		SignalSemaphore.clear();
-		Images.clear();
-		nosVulkan->DestroySwapchain(&Swapchain);
+		RetireSwapchain();
+		Swapchain.ReleaseAllRetired();
+	}
+
+	// Used on recreation, nothing is waited for. The new swapchain takes over the surface, the retired one is destroyed with
+	// its semaphores once this output's frames that still use its images and the presents after them have completed.
+	void RetireSwapchain()
+	{
+		if (!Backend || !Backend->HasSwapchain())
+			return;
+		Swapchain.Retire(SubmittedFrames + Swapchain.GetImageCount());
+		AcquiredImage = std::nullopt;
 	}
 
 	void DestroyWindowSurface()
 	{
-		if (!Surface)
+		if (!Backend)
 			return;
-		nosVulkan->DestroyWindowSurface(&Surface);
+		Backend->DestroySurface();
 	}
 
 	void DestroyWindow()
 	{
 		if (!Window)
 			return;
-		glfwDestroyWindow(Window);
-		glfwTerminate();
+		Runtime->ReleaseWindow(Window);
 		Window = nullptr;
+		// Nothing is pushed once the window is released, drop what the next window should not see
+		WindowEvent event;
+		while (WindowEvents.Pop(event))
+			;
 	}
 
 	nosResult ExecuteNode(nosNodeExecuteParams* params) override
 	{
-		if (!Window)
+		if (!Backend || (!Window && !Backend->IsHeadless()))
 			return NOS_RESULT_FAILED;
 		nosScheduleNodeParams scheduleParams = {};
 		scheduleParams.NodeId = NodeId;
@@ -213,36 +260,120 @@ struct DisplayOutNode : NodeContext
 		auto input = vkss::DeserializeTextureInfo(execParams[NOS_NAME("Input")].Data->Data);
 		if (!input.Memory.Handle)
 			return NOS_RESULT_FAILED;
+		// A run the node scheduled for itself at a deadline sees the upstream frame of the run before it, only a run that
+		// asked for a new frame brings one, whether or not upstream reuses its texture
+		if (!std::exchange(WaitingForDeadline, false))
+			++UpstreamFrame;
+		Inputs.Receive(input, UpstreamFrame);
 
-		if (!glfwWindowShouldClose(Window))
+		if (!Window || ProcessWindowEvents())
 		{
-			glfwPollEvents();
-			const char* errDesc;
-			int err = glfwGetError(&errDesc);
-			if (err != GLFW_NO_ERROR)
+			// Nothing is acquired or presented while hidden, the node only keeps a heartbeat to notice when it is shown again
+			if (!UpdateVisibility())
+			{
+				HeartbeatPacer.TryReleaseFrame();
+				ScheduleAt(HeartbeatPacer.GetNextDeadline());
+				return NOS_RESULT_SUCCESS;
+			}
+
+			// Nothing blocks until the frame deadline, the node runs again at the deadline through the timer and presents
+			// what the input policy picks then
+			std::optional<PacingClock::TimePoint> released = FramePacing ? Pacer.TryReleaseFrame() : Pacer.MarkFrame();
+			if (!released)
 			{
-				nosEngine.LogE("Error: %s", errDesc);
+				ScheduleAt(Pacer.GetNextDeadline());
+				return NOS_RESULT_SUCCESS;
+			}
+			UpdateStatsPins(*released);
+			util::Stopwatch frameWatch;
+			PollInFlightFrames(0);
+
+			// Every geometry and setting change since the last frame is applied with a single recreation
+			if ((SwapchainDirty || !Backend->HasSwapchain()) && !TryCreateSwapchain())
 				return NOS_RESULT_FAILED;
+
+			// A new swapchain shows nothing until something is presented, so it always gets the last input again
+			auto frame = Inputs.Next(Policy, SwapchainNeedsFrame);
+			if (!frame)
+			{
+				ScheduleAt(Pacer.GetNextDeadline());
+				return NOS_RESULT_SUCCESS;
 			}
+			SwapchainNeedsFrame = false;
+
+			util::Stopwatch stageWatch;
+			auto endStage = [&](PresentStage stage) {
+				StageStats.Add(stage, std::chrono::duration_cast<std::chrono::nanoseconds>(stageWatch.Elapsed()));
+				stageWatch = {};
+			};
+
+			// Keep at most MaxFramesInFlight frames queued: wait for exactly the frame whose slot is about to be reused
+			if (SubmittedFrames >= MaxFramesInFlight)
+				PollInFlightFrames(SubmittedFrames + 1 - MaxFramesInFlight);
+			endStage(PresentStage::FrameWait);
 
 			uint32_t imageIndex;
-			nosVulkan->SwapchainAcquireNextImage(Swapchain, -1, &imageIndex, WaitSemaphore[CurrentFrame]);
-			nosCmd cmd;
-			nosVulkan->Begin("Window", &cmd);
-			nosVulkan->Copy(cmd, &input, &Images[imageIndex], 0);
+			// An image acquired ahead for zero-copy was already waited for
+			bool acquiredAhead = AcquiredImage.has_value();
+			if (acquiredAhead)
+			{
+				imageIndex = *std::exchange(AcquiredImage, std::nullopt);
+				stageWatch = {};
+			}
+			else
+			{
+				auto result = Backend->AcquireNextImage(GetAcquireTimeout(), &imageIndex, Swapchain.AcquireSemaphores[CurrentFrame]);
+				endStage(PresentStage::Acquire);
+				if (result != NOS_RESULT_SUCCESS)
+				{
+					OnAcquireFailed(result, *frame);
+					nosEngine.ScheduleNode(&scheduleParams);
+					return NOS_RESULT_SUCCESS;
+				}
+				AcquireStalled = false;
+			}
+			if (!Backend->IsHeadless())
+			{
+				nosCmd cmd;
+				nosCmdBeginParams beginParams = { .Name = NOS_NAME_STATIC("Window"), .AssociatedNodeId = NodeId, .OutCmdHandle = &cmd };
+				nosVulkan->Begin2(&beginParams);
+				// Upstream rendered straight into the published image, anything else goes through the present pass
+				auto& image = Swapchain.Images[imageIndex];
+				if (!acquiredAhead || frame->Memory.Handle != image.Memory.Handle)
+					RecordPresentPass(cmd, *frame, image, PresentSettings);
 
-			nosVulkan->ImageStateToPresent(cmd, &Images[imageIndex]);
-			nosVulkan->AddWaitSemaphoreToCmd(cmd, WaitSemaphore[CurrentFrame], 1);
-			nosVulkan->AddSignalSemaphoreToCmd(cmd, SignalSemaphore[CurrentFrame], 1);
+				nosVulkan->ImageStateToPresent(cmd, &image);
+				if (!acquiredAhead)
+					nosVulkan->AddWaitSemaphoreToCmd(cmd, Swapchain.AcquireSemaphores[CurrentFrame], 1);
+				nosVulkan->AddSignalSemaphoreToCmd(cmd, Swapchain.PresentSemaphores[imageIndex], 1);
+				endStage(PresentStage::Record);
 
-			nosCmdEndParams endParams{ .ForceSubmit = true };
-			nosVulkan->End(cmd, &endParams);
-			if (nosVulkan->SwapchainPresent(Swapchain, imageIndex, SignalSemaphore[CurrentFrame]) != NOS_RESULT_SUCCESS)
+				nosGPUEvent gpuEvent{};
+				nosCmdEndParams endParams{ .ForceSubmit = true, .OutGPUEventHandle = &gpuEvent };
+				nosVulkan->End(cmd, &endParams);
+				endStage(PresentStage::Submit);
+				TrackSubmittedFrame(gpuEvent);
+			}
+			if (Backend->Present(imageIndex, Swapchain.PresentSemaphores[imageIndex]) == NOS_RESULT_SUCCESS)
 			{
+				CurrentFrame = (CurrentFrame + 1) % MaxFramesInFlight;
+				if (StartupWatch)
+					ReportTimeToFirstPresent();
+			}
+			else
 				TryCreateSwapchain();
+			endStage(PresentStage::Present);
+			bool scheduled = false;
+			if (ZeroCopy && Backend->HasSwapchain())
+			{
+				scheduled = AcquireRenderTarget();
+				endStage(PresentStage::Acquire);
 			}
-			nosEngine.ScheduleNode(&scheduleParams);
-			CurrentFrame = (CurrentFrame + 1) % FrameCount;
+			else if (RenderTargetPublished)
+				PublishRenderTarget(std::nullopt);
+			if (!scheduled)
+				nosEngine.ScheduleNode(&scheduleParams);
+			StageStats.Add(PresentStage::Frame, std::chrono::duration_cast<std::chrono::nanoseconds>(frameWatch.Elapsed()));
 		}
 		else
 		{
@@ -264,74 +395,36 @@ struct DisplayOutNode : NodeContext
 	{
 		if (!runnerId)
 			return;
-		glfwInit();
-		UpdateStringList(std::string("Monitor_") + UUID2STR(NodeId), GetPossibleMonitors());
-		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
-		Window = glfwCreateWindow(Resolution.x, Resolution.y, GetWindowName().c_str(), nullptr, nullptr);
-		glfwSetInputMode(Window, GLFW_CURSOR, ShowCursor ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED);
-		glfwSetWindowUserPointer(Window, this);
-		glfwSetWindowSizeCallback(Window, [](GLFWwindow* window, int width, int height) {
-			auto node = (DisplayOutNode*)glfwGetWindowUserPointer(window);
-			if (node->IsWindowLocked())
-			{
-				if (node->Resolution.x != width || node->Resolution.y != height)
-				{
-					if (auto monitor = node->GetGLFWMonitor())
-					{
-						int monitorPosX, monitorPosY;
-						glfwGetMonitorPos(monitor, &monitorPosX, &monitorPosY);
-						glfwSetWindowPos(window, monitorPosX, monitorPosY);
-						glfwSetWindowSize(window, node->Resolution.x, node->Resolution.y);
-						return;
-					}
-					else // Monitor lost?
-						node->RevertMonitorResolution(false);
-				}
-				else
-				{
-					node->TryCreateSwapchain();
-					return;
-				}
-			}
-			node->TryCreateSwapchain();
-		});
-		glfwSetWindowIconifyCallback(Window, [](GLFWwindow* window, int iconified) {
-			auto node = (DisplayOutNode*)glfwGetWindowUserPointer(window);
-			if (iconified == GLFW_TRUE && node->IsWindowLocked())
-				glfwRestoreWindow(window);
-		});
-		//glfwSetWindowFocusCallback(Window, [](GLFWwindow* window, int focused) {
-		//	auto node = (DisplayOutNode*)glfwGetWindowUserPointer(window);
-		//	if (focused == GLFW_FALSE && node->IsWindowLocked())
-		//		glfwFocusWindow(window);
-		//});
-		glfwSetWindowCloseCallback(Window, [](GLFWwindow* window) {
-			auto node = (DisplayOutNode*)glfwGetWindowUserPointer(window);
-			if(node->IsWindowLocked())
-				glfwSetWindowShouldClose(window, GLFW_FALSE);
-		});
-
-		glfwSetWindowPosCallback(Window, [](GLFWwindow* window, int posx, int posy)
-			{
-				auto node = (DisplayOutNode*)glfwGetWindowUserPointer(window);
-				if (node->IsWindowLocked())
-				{
-					if (auto monitor = node->GetGLFWMonitor())
-					{
-						int monitorPosX, monitorPosY;
-						glfwGetMonitorPos(monitor, &monitorPosX, &monitorPosY);
-						if (monitorPosX != posx || monitorPosY != posy)
-						{
-							glfwSetWindowPos(window, monitorPosX, monitorPosY);
-							return;
-						}
-					}
-					else // Monitor lost?
-						node->RevertMonitorResolution(false);
-				}
+		StartupWatch = util::Stopwatch();
+		Timer = ScheduleTimer::Acquire();
+		if (Headless)
+		{
+			Backend = std::make_unique<NullPresentBackend>();
+			Backend->CreateSurface(nullptr);
+			TryCreateSwapchain();
+			return;
+		}
+		Backend = CreateVulkanPresentBackend();
+		Runtime = WindowRuntime::Acquire();
+		if (!Runtime)
+			return;
+		StageStats.Add(PresentStage::MonitorEnumeration, Runtime->GetLastMonitorEnumerationTime());
+		UpdateMonitorList();
+		// The monitor mode is switched before the window exists, so the window and its swapchain are created once, at their
+		// final geometry, instead of being moved, resized and rebuilt after creation.
+		if (LockedMonitorPort)
+			UpdateCustomResolution();
+		WindowEvents.Locked = IsWindowLocked();
+		Window = Runtime->OpenWindow(GetStartupGeometry(), GetWindowName(), &WindowEvents);
+		if (!Window)
+			return;
+		// A fullscreen window without a locked monitor covers the monitor it was opened on, before its swapchain is built
+		if (Fullscreen && !LockedMonitorPort)
+			Runtime->Invoke([window = Window] {
+				if (auto monitor = get_current_monitor(window))
+					CoverMonitor(window, monitor);
 			});
-
+		UpdateCursorMode();
 
 		auto windowHandle =
 #if defined(WIN32)
@@ -342,23 +435,38 @@ struct DisplayOutNode : NodeContext
 #error "Unsupported platform"
 #endif
 			;
-		if (nosVulkan->CreateWindowSurface((void*)windowHandle, &Surface) != NOS_RESULT_SUCCESS)
+		if (!Backend->CreateSurface((void*)windowHandle))
 		{
 			DestroyWindow();
 			return;
 		}
 		TryCreateSwapchain();
-		if (LockedMonitorPort)
-		{
-			MoveToMonitor();
-			UpdateCustomResolution();
-		}
-		if (Fullscreen)
-			MakeFullscreen();
+	}
+
+	WindowGeometry GetStartupGeometry()
+	{
+		WindowGeometry geometry{ .Size = Resolution, .Decorated = !Fullscreen };
+		// Without a locked monitor the window system places the window, see OnEnterRunnerThread
+		auto monitor = LockedMonitorPort ? GetGLFWMonitor() : nullptr;
+		if (!monitor)
+			return geometry;
+		Runtime->Invoke([&] {
+			int monitorPosX, monitorPosY;
+			glfwGetMonitorPos(monitor, &monitorPosX, &monitorPosY);
+			geometry.Position = nosVec2i{ monitorPosX, monitorPosY };
+			if (Fullscreen)
+			{
+				auto mode = glfwGetVideoMode(monitor);
+				geometry.Size = { uint32_t(mode->width), uint32_t(mode->height) };
+			}
+		});
+		return geometry;
 	}
 
 	void OnPathStop() override
 	{
+		if (Timer)
+			Timer->Cancel(NodeId);
 		nosCmd cmd;
 		nosCmdBeginParams beginParams = { .Name = NOS_NAME("Window node flush cmd"), .AssociatedNodeId = NodeId, .OutCmdHandle = &cmd };
 		nosVulkan->Begin2(&beginParams);
@@ -370,6 +478,8 @@ struct DisplayOutNode : NodeContext
 
 	void OnPathStart() override
 	{
+		// A deadline run cancelled by the stop is not coming, the first run of the path brings a new frame
+		WaitingForDeadline = false;
 		nosScheduleNodeParams params = {};
 		params.NodeId = NodeId;
 		params.Reset = false;
@@ -385,7 +495,11 @@ struct DisplayOutNode : NodeContext
 			Resolution = *InterpretPinValue<nosVec2u>(value);
 			if (Window)
 			{
-				glfwSetWindowSize(Window, Resolution.x, Resolution.y);
+				Runtime->Post([window = Window, resolution = Resolution] { glfwSetWindowSize(window, resolution.x, resolution.y); });
+			}
+			else if (Backend && Backend->IsHeadless())
+			{
+				RequestSwapchainRecreate();
 			}
 		}
 		else if (pinName == NOS_NAME_STATIC("Fullscreen"))
@@ -399,28 +513,188 @@ struct DisplayOutNode : NodeContext
 				}
 				else
 				{
-					glfwSetWindowAttrib(Window, GLFW_DECORATED, GLFW_TRUE);
+					Runtime->Post([window = Window] { glfwSetWindowAttrib(window, GLFW_DECORATED, GLFW_TRUE); });
 				}
 			}
 		}
+		else if (pinName == NOS_NAME_STATIC("PresentMode"))
+		{
+			auto presentMode = ParsePresentMode(InterpretPinValue<const char>(value));
+			if (!presentMode)
+			{
+				nosEngine.LogE("Unknown present mode: %s", InterpretPinValue<const char>(value));
+				return;
+			}
+			if (*presentMode == PresentMode)
+				return;
+			PresentMode = *presentMode;
+			RequestSwapchainRecreate();
+		}
 		else if (pinName == NOS_NAME_STATIC("VSync"))
 		{
-			VSync = *InterpretPinValue<bool>(value);
-			TryCreateSwapchain();
+			// Only kept so that graphs saved before PresentMode existed keep their VSync setting: on is moved over to PresentMode
+			// as FIFO and reset, so it does not override PresentMode when the graph is loaded again. Off is Immediate, the
+			// PresentMode default.
+			if (!*InterpretPinValue<bool>(value))
+				return;
+			SetPinValue(NOS_NAME_STATIC("PresentMode"), GetPresentModeName(NOS_PRESENT_MODE_FIFO));
+			SetPinValue(NOS_NAME_STATIC("VSync"), nos::Buffer::From(false));
+		}
+		else if (pinName == NOS_NAME_STATIC("ScaleMode"))
+		{
+			auto scaleMode = ParsePresentScaleMode(InterpretPinValue<const char>(value));
+			if (!scaleMode)
+			{
+				nosEngine.LogE("Unknown scale mode: %s", InterpretPinValue<const char>(value));
+				return;
+			}
+			PresentSettings.ScaleMode = *scaleMode;
+		}
+		else if (pinName == NOS_NAME_STATIC("InputPolicy"))
+		{
+			auto policy = ParseInputPolicy(InterpretPinValue<const char>(value));
+			if (!policy)
+			{
+				nosEngine.LogE("Unknown input policy: %s", InterpretPinValue<const char>(value));
+				return;
+			}
+			Policy = *policy;
+		}
+		else if (pinName == NOS_NAME_STATIC("AcquireTimeout"))
+		{
+			AcquireTimeout = std::max(*InterpretPinValue<float>(value), 0.0f);
+		}
+		else if (pinName == NOS_NAME_STATIC("AcquireTimeoutPolicy"))
+		{
+			std::string_view policyName = InterpretPinValue<const char>(value);
+			auto policy = std::find(std::begin(AcquireTimeoutPolicyNames), std::end(AcquireTimeoutPolicyNames), policyName);
+			if (policy == std::end(AcquireTimeoutPolicyNames))
+			{
+				nosEngine.LogE("Unknown acquire timeout policy: %s", InterpretPinValue<const char>(value));
+				return;
+			}
+			TimeoutPolicy = AcquireTimeoutPolicy(policy - std::begin(AcquireTimeoutPolicyNames));
+		}
+		else if (pinName == NOS_NAME_STATIC("Letterbox"))
+		{
+			PresentSettings.Letterbox = *InterpretPinValue<bool>(value);
+		}
+		else if (pinName == NOS_NAME_STATIC("Dither"))
+		{
+			PresentSettings.Dither = *InterpretPinValue<bool>(value);
+		}
+		else if (pinName == NOS_NAME_STATIC("Rotation"))
+		{
+			auto rotation = ParsePresentRotation(InterpretPinValue<const char>(value));
+			if (!rotation)
+			{
+				nosEngine.LogE("Unknown rotation: %s", InterpretPinValue<const char>(value));
+				return;
+			}
+			PresentSettings.Rotation = *rotation;
+			WarnIfTransformBypassed();
+		}
+		else if (pinName == NOS_NAME_STATIC("FlipHorizontal"))
+		{
+			PresentSettings.FlipHorizontal = *InterpretPinValue<bool>(value);
+			WarnIfTransformBypassed();
+		}
+		else if (pinName == NOS_NAME_STATIC("FlipVertical"))
+		{
+			PresentSettings.FlipVertical = *InterpretPinValue<bool>(value);
+			WarnIfTransformBypassed();
+		}
+		else if (pinName == NOS_NAME_STATIC("Crop"))
+		{
+			auto crop = *InterpretPinValue<nosVec4>(value);
+			PresentSettings.SourceRect = { std::max(crop.x, 0.0f), std::max(crop.y, 0.0f), std::max(crop.z, 0.0f), std::max(crop.w, 0.0f) };
+			WarnIfTransformBypassed();
+		}
+		else if (pinName == NOS_NAME_STATIC("Offset"))
+		{
+			auto offset = *InterpretPinValue<nosVec2i>(value);
+			PresentSettings.OffsetX = offset.x;
+			PresentSettings.OffsetY = offset.y;
+			WarnIfTransformBypassed();
+		}
+		else if (pinName == NOS_NAME_STATIC("MaxFramesInFlight"))
+		{
+			uint32_t maxFramesInFlight = std::clamp(*InterpretPinValue<uint32_t>(value), 1u, uint32_t(InFlightFrames.size()));
+			if (maxFramesInFlight == MaxFramesInFlight)
+				return;
+			MaxFramesInFlight = maxFramesInFlight;
+			RequestSwapchainRecreate();
+		}
+		else if (pinName == NOS_NAME_STATIC("FramePacing"))
+		{
+			FramePacing = *InterpretPinValue<bool>(value);
+			Pacer.Reset();
+		}
+		else if (pinName == NOS_NAME_STATIC("Headless"))
+		{
+			bool headless = *InterpretPinValue<bool>(value);
+			if (headless != Headless && Backend)
+				nosEngine.LogW("Headless change will take effect when the node enters a runner thread again");
+			Headless = headless;
+		}
+		else if (pinName == NOS_NAME_STATIC("ZeroCopy"))
+		{
+			// An image that is already acquired is still presented by the next frame
+			ZeroCopy = *InterpretPinValue<bool>(value);
+			WarnIfTransformBypassed();
+		}
+		else if (pinName == NOS_NAME_STATIC("HiddenHeartbeatRate"))
+		{
+			HiddenHeartbeatRate = std::max(*InterpretPinValue<float>(value), 0.1f);
+			HeartbeatPacer.SetTargetRate(HiddenHeartbeatRate);
+		}
+		else if (pinName == NOS_NAME_STATIC("LogLatencyStats"))
+		{
+			LogLatencyStats = *InterpretPinValue<bool>(value);
 		}
 		else if (pinName == NOS_NAME_STATIC("RefreshRate"))
 		{
 			RefreshRate = *InterpretPinValue<float>(value);
+			Pacer.SetTargetRate(RefreshRate);
 			if (CustomResolutionSet)
 				UpdateCustomResolution();
 		}
+		else if (pinName == NOS_NAME_STATIC("TimingStandard"))
+		{
+			auto standard = ParseTimingStandard(InterpretPinValue<const char>(value));
+			if (!standard)
+			{
+				nosEngine.LogE("Unknown timing standard: %s", InterpretPinValue<const char>(value));
+				return;
+			}
+			if (*standard == Standard)
+				return;
+			Standard = *standard;
+			if (CustomResolutionSet)
+				UpdateCustomResolution();
+		}
+		else if (pinName == NOS_NAME_STATIC("Link"))
+		{
+			auto link = ParseDisplayLink(InterpretPinValue<const char>(value));
+			if (!link)
+			{
+				nosEngine.LogE("Unknown display link: %s", InterpretPinValue<const char>(value));
+				return;
+			}
+			Link = *link;
+		}
 		else if (pinName == NSN_Monitor)
 		{
-			const char* monitorName = InterpretPinValue<const char>(value);
-			if (strcmp(monitorName, "NONE") == 0 || strlen(monitorName) == 0)
+			std::string_view monitorName = InterpretPinValue<const char>(value);
+			if (monitorName == "NONE" || monitorName.empty())
+				return;
+			auto newKey = ParseMonitorLabel(monitorName);
+			if (!newKey)
+			{
+				nosEngine.LogW("Unrecognized monitor: %.*s", int(monitorName.size()), monitorName.data());
 				return;
-			auto newPort = GetPortFromString(monitorName);
-			if (newPort == LockedMonitorPort)
+			}
+			if (newKey == LockedMonitorKey)
 				return;
 			bool customResolutionWasSet = CustomResolutionSet;
 			if (CustomResolutionSet)
@@ -428,7 +702,9 @@ struct DisplayOutNode : NodeContext
 				RevertMonitorResolution(false);
 			}
 
-			LockedMonitorPort = newPort;
+			LockedMonitorKey = newKey;
+			LockedMonitorPort = ResolveMonitorKey(*newKey);
+			// Resolved again when the topology is (re)built, e.g. when the pin is loaded before the monitors are enumerated
 			if (!LockedMonitorPort)
 				return;
 			MoveToMonitor();
@@ -438,16 +714,14 @@ struct DisplayOutNode : NodeContext
 		else if (pinName == NOS_NAME_STATIC("ShowCursor"))
 		{
 			ShowCursor = *InterpretPinValue<bool>(value);
-			if (Window)
-				glfwSetInputMode(Window, GLFW_CURSOR, ShowCursor ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED);
+			UpdateCursorMode();
 		}
 		else if (pinName == NOS_NAME_STATIC("WindowName"))
 		{
 			WindowName = InterpretPinValue<const char>(value);
 			if(WindowName == "NONE")
 				WindowName = std::nullopt;
-			if (Window)
-				glfwSetWindowTitle(Window, GetWindowName().c_str());
+			UpdateWindowTitle();
 		}
 	}
 
@@ -456,39 +730,172 @@ struct DisplayOutNode : NodeContext
 		if (WindowName)
 			return;
 		if (update->Type == NOS_NODE_UPDATE_DISPLAY_NAME || update->Type == NOS_NODE_UPDATE_UNIQUE_NAME)
-			if (Window)
-				glfwSetWindowTitle(Window, GetWindowName().c_str());
+			UpdateWindowTitle();
 	}
 
-	void MoveToMonitor()
+	// Drains the events the window runtime collected since the last frame. Returns false if the window was closed.
+	bool ProcessWindowEvents()
 	{
-		if (!Window)
+		WindowEvents.Locked = IsWindowLocked();
+		bool monitorsChanged = false;
+		// Only the last size and position matter, a drag or a fullscreen toggle produces a burst of them
+		std::optional<WindowEvent> resized, moved;
+		WindowEvent event;
+		while (Window && WindowEvents.Pop(event))
 		{
-			nosEngine.LogE("Window not found");
+			switch (event.Type)
+			{
+			case WindowEventType::Resized:
+				if (resized)
+					++SwapchainRecreationsAvoided;
+				resized = event;
+				break;
+			case WindowEventType::Moved: moved = event; break;
+			case WindowEventType::Iconified: Iconified = true; break;
+			case WindowEventType::Restored: Iconified = false; break;
+			case WindowEventType::CloseRequested: return false;
+			case WindowEventType::MonitorsChanged: monitorsChanged = true; break;
+			default: break;
+			}
+		}
+		if (resized)
+			OnWindowResized(resized->X, resized->Y);
+		if (moved && Window)
+			OnWindowMoved(moved->X, moved->Y);
+		// Also catches monitor changes whose events were dropped by a full queue
+		if (auto customRes = CustomResolutionBase::Get(); customRes && customRes->GetTopologyGeneration() != KnownTopologyGeneration)
+			monitorsChanged = true;
+		if (monitorsChanged)
+		{
+			StageStats.Add(PresentStage::MonitorEnumeration, Runtime->GetLastMonitorEnumerationTime());
+			UpdateMonitorList();
+		}
+		return true;
+	}
+
+	// The swapchain is recreated at the start of the next frame, once for every request made until then
+	void RequestSwapchainRecreate()
+	{
+		if (SwapchainDirty)
+			++SwapchainRecreationsAvoided;
+		SwapchainDirty = true;
+	}
+
+	void OnWindowResized(int width, int height)
+	{
+		// Minimized windows report a zero size on some platforms, there is no swapchain to create until they are restored
+		ZeroExtent = width == 0 || height == 0;
+		if (ZeroExtent)
 			return;
+		// E.g. the size event of the window being created, the swapchain was already built for it
+		if (Backend->HasSwapchain() && Swapchain.Extent.x == uint32_t(width) && Swapchain.Extent.y == uint32_t(height))
+			return;
+		if (IsWindowLocked() && (Resolution.x != width || Resolution.y != height))
+		{
+			if (auto monitor = GetGLFWMonitor())
+			{
+				PlaceWindowOnMonitor(monitor, Resolution);
+				return;
+			}
+			else // Monitor lost?
+				RevertMonitorResolution(false);
 		}
+		RequestSwapchainRecreate();
+	}
+
+	// GLFW reports no occlusion, and losing focus does not hide a window: an output is hidden while it is minimized, has
+	// no area or its locked monitor is disconnected.
+	bool UpdateVisibility()
+	{
+		bool visible = Backend->IsHeadless() || (!Iconified && !ZeroExtent && !MonitorLost);
+		if (visible == Visible)
+			return visible;
+		Visible = visible;
+		SetPinValue(NOS_NAME_STATIC("Visible"), nos::Buffer::From(visible));
+		HeartbeatPacer.Reset();
+		Pacer.Reset();
+		return visible;
+	}
+
+	void OnWindowMoved(int posx, int posy)
+	{
+		if (!IsWindowLocked())
+			return;
 		if (auto monitor = GetGLFWMonitor())
 		{
+			Runtime->Post([window = Window, monitor, posx, posy] {
+				int monitorPosX, monitorPosY;
+				glfwGetMonitorPos(monitor, &monitorPosX, &monitorPosY);
+				if (monitorPosX != posx || monitorPosY != posy)
+					glfwSetWindowPos(window, monitorPosX, monitorPosY);
+			});
+		}
+		else // Monitor lost?
+			RevertMonitorResolution(false);
+	}
+
+	// Window changes are applied asynchronously on the window runtime's event thread
+	void PlaceWindowOnMonitor(GLFWmonitor* monitor, std::optional<nosVec2u> size = std::nullopt)
+	{
+		Runtime->Post([window = Window, monitor, size] {
 			int monitorPosX, monitorPosY;
 			glfwGetMonitorPos(monitor, &monitorPosX, &monitorPosY);
-			glfwSetWindowPos(Window, monitorPosX, monitorPosY);
+			glfwSetWindowPos(window, monitorPosX, monitorPosY);
+			if (size)
+				glfwSetWindowSize(window, size->x, size->y);
+		});
+	}
+
+	void UpdateWindowTitle()
+	{
+		if (!Window)
+			return;
+		Runtime->Post([window = Window, title = GetWindowName()] { glfwSetWindowTitle(window, title.c_str()); });
+	}
+
+	void UpdateCursorMode()
+	{
+		if (!Window)
+			return;
+		Runtime->Post([window = Window, showCursor = ShowCursor] { glfwSetInputMode(window, GLFW_CURSOR, showCursor ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED); });
+	}
+
+	// Frames rendered straight into the render target are presented as is, only copied inputs go through the transform
+	void WarnIfTransformBypassed()
+	{
+		if (ZeroCopy && PresentSettings.HasTransform())
+			nosEngine.LogW("%s: Rotation, flip, crop and offset are not applied to frames rendered into RenderTarget", GetDisplayName().c_str());
+	}
+
+	void MoveToMonitor()
+	{
+		if (!Window)
+		{
+			nosEngine.LogE("Window not found");
+			return;
 		}
+		if (auto monitor = GetGLFWMonitor())
+			PlaceWindowOnMonitor(monitor);
 	}
 
 	std::optional<GPUPortIdentifier> GetWindowGPUPortId()
 	{
 		if(LockedMonitorPort.has_value())
 			return *LockedMonitorPort;
-		auto monitor = get_current_monitor(Window);
-		if (!monitor)
-			monitor = glfwGetWindowMonitor(Window);
+		if (!Window)
+			return std::nullopt;
+		auto monitor = Runtime->Invoke([window = Window] {
+			auto monitor = get_current_monitor(window);
+			return monitor ? monitor : glfwGetWindowMonitor(window);
+		});
 		if (!monitor)
 			return std::nullopt;
-#if defined(WIN32)
-		const char* adapterName = glfwGetWin32Adapter(monitor);
-#endif
 		if (auto customRes = CustomResolutionBase::Get())
-			return customRes->GetGPUPortIdFromAdapterName(adapterName);
+		{
+			auto topology = customRes->GetTopology();
+			if (auto entry = topology->FindByMonitor(monitor))
+				return entry->Port;
+		}
 		return std::nullopt;
 	}
 
@@ -497,8 +904,12 @@ struct DisplayOutNode : NodeContext
 		auto port = GetWindowGPUPortId();
 		if (!port)
 			return nullptr;
-		if(auto adapterName = CustomResolutionBase::Get()->GetAdapterName(*port, GetPossibleAdapterNames()))
-			return GetGLFWMonitorFromAdapterName(adapterName->c_str());
+		if (auto customRes = CustomResolutionBase::Get())
+		{
+			auto topology = customRes->GetTopology();
+			if (auto entry = topology->FindByPort(*port))
+				return (GLFWmonitor*)entry->Monitor;
+		}
 		return nullptr;
 	}
 
@@ -509,7 +920,7 @@ struct DisplayOutNode : NodeContext
 			nosEngine.LogE("CustomResolutionBase not found");
 			return;
 		}
-		if (!Window)
+		if (!Window && !LockedMonitorPort)
 		{
 			nosEngine.LogE("Window not found");
 			return;
@@ -525,7 +936,9 @@ struct DisplayOutNode : NodeContext
 			.Resolution = Resolution,
 			.RefreshRate = RefreshRate,
 			.ColorDepth = ColorDepth,
-			.ColorFormat = ColorFormat
+			.ColorFormat = ColorFormat,
+			.Standard = Standard,
+			.Link = Link,
 		};
 		if(CustomResolutionSet)
 			RevertMonitorResolution(true);
@@ -556,6 +969,7 @@ struct DisplayOutNode : NodeContext
 				if (setMonitorPin)
 				{
 					LockedMonitorPort = std::nullopt;
+					LockedMonitorKey = std::nullopt;
 					UpdateMonitorString();
 				}
 			}
@@ -570,17 +984,23 @@ struct DisplayOutNode : NodeContext
 			nosEngine.LogE("Monitor not found");
 			return;
 		}
+		Runtime->Post([window = Window, monitor] { CoverMonitor(window, monitor); });
+	}
+
+	// Runs on the window runtime's event thread
+	static void CoverMonitor(GLFWwindow* window, GLFWmonitor* monitor)
+	{
 		auto mode = glfwGetVideoMode(monitor);
 		int monitorPosX, monitorPosY;
 		glfwGetMonitorPos(monitor, &monitorPosX, &monitorPosY);
-		glfwSetWindowPos(Window, monitorPosX, monitorPosY);
-		glfwSetWindowSize(Window, mode->width, mode->height);
-		glfwSetWindowAttrib(Window, GLFW_DECORATED, GLFW_FALSE);
+		glfwSetWindowPos(window, monitorPosX, monitorPosY);
+		glfwSetWindowSize(window, mode->width, mode->height);
+		glfwSetWindowAttrib(window, GLFW_DECORATED, GLFW_FALSE);
 	}
 
 	static nosResult GetFunctions(size_t* outCount, nosName* outFunctionNames, nosPfnNodeFunctionExecute* outFunction)
 	{
-		*outCount = 2;
+		*outCount = 3;
 		if (!outFunctionNames)
 			return NOS_RESULT_SUCCESS;
 		outFunctionNames[0] = NOS_NAME_STATIC("ForceUpdateMonitorResolution");
@@ -595,9 +1015,170 @@ struct DisplayOutNode : NodeContext
 				reinterpret_cast<DisplayOutNode*>(ctx)->RevertMonitorResolution(true);
 				return NOS_RESULT_SUCCESS;
 			};
+		outFunctionNames[2] = NOS_NAME_STATIC("RefreshMonitors");
+		outFunction[2] = [](void* ctx, nosFunctionExecuteParams* functionParams)
+			{
+				// Monitors can only be enumerated on the event thread, a temporary runtime is started if no window is open
+				if (auto runtime = WindowRuntime::Acquire())
+					runtime->RefreshMonitors();
+				reinterpret_cast<DisplayOutNode*>(ctx)->UpdateMonitorList();
+				return NOS_RESULT_SUCCESS;
+			};
 		return NOS_RESULT_SUCCESS;
 	}
 
+	void ReportTimeToFirstPresent()
+	{
+		float ms = std::chrono::duration<float, std::milli>(StartupWatch->Elapsed()).count();
+		StartupWatch = std::nullopt;
+		SetPinValue(NOS_NAME_STATIC("TimeToFirstPresent"), nos::Buffer::From(ms));
+		nosEngine.LogI("%s: First frame presented %.1f ms after start", GetWindowName().c_str(), ms);
+	}
+
+	// Runs the node again at time instead of blocking the runner thread until then, right away without a time. The run
+	// presents what is already queued, it does not ask upstream for a new frame.
+	void ScheduleAt(std::optional<PacingClock::TimePoint> time)
+	{
+		WaitingForDeadline = true;
+		if (time && Timer)
+		{
+			Timer->ScheduleNodeAt(NodeId, *time);
+			return;
+		}
+		nosScheduleNodeParams params = {};
+		params.NodeId = NodeId;
+		params.Reset = false;
+		params.AddScheduleCount = 1;
+		nosEngine.ScheduleNode(&params);
+	}
+
+	uint64_t GetAcquireTimeout() const
+	{
+		return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<float, std::milli>(AcquireTimeout)).count());
+	}
+
+	// The graph keeps running when the presentation engine stalls: a timed out frame is handled by the timeout policy,
+	// any other failure means the swapchain has to be recreated.
+	void OnAcquireFailed(nosResult result, nosResourceShareInfo const& frame)
+	{
+		if (result != NOS_RESULT_TIMEOUT)
+		{
+			TryCreateSwapchain();
+			return;
+		}
+		++AcquireTimeouts;
+		SetPinValue(NOS_NAME_STATIC("AcquireTimeouts"), nos::Buffer::From(uint32_t(AcquireTimeouts)));
+		if (!AcquireStalled)
+			nosEngine.LogW("%s: Swapchain image acquire timed out after %.1f ms", GetWindowName().c_str(), AcquireTimeout);
+		AcquireStalled = true;
+		switch (TimeoutPolicy)
+		{
+		case AcquireTimeoutPolicy::Skip: break;
+		case AcquireTimeoutPolicy::Retry: Inputs.PutBack(frame); break;
+		case AcquireTimeoutPolicy::Recreate: TryCreateSwapchain(); break;
+		}
+	}
+
+	// Acquires the image the next frame presents and publishes it on RenderTarget, so that upstream can render into it
+	// instead of into a texture that is then copied. Upstream cannot wait on the acquire semaphore, so a command waiting on it
+	// is submitted here and the node, with upstream, only runs again once it has completed. Returns true if the node is
+	// scheduled that way.
+	bool AcquireRenderTarget()
+	{
+		uint32_t imageIndex;
+		// Not the frame slot's acquire semaphore, which a frame still in flight may wait on until the next frame's slot wait
+		auto semaphore = Swapchain.AcquireAheadSemaphores[CurrentFrame];
+		// On failure the next frame acquires the usual way, with the timeout policy applied
+		if (Backend->AcquireNextImage(GetAcquireTimeout(), &imageIndex, semaphore) != NOS_RESULT_SUCCESS)
+		{
+			if (RenderTargetPublished)
+				PublishRenderTarget(std::nullopt);
+			return false;
+		}
+		AcquiredImage = imageIndex;
+		if (Backend->IsHeadless() || !Timer)
+			return false;
+		nosCmd cmd;
+		nosCmdBeginParams beginParams = { .Name = NOS_NAME("Window acquire cmd"), .AssociatedNodeId = NodeId, .OutCmdHandle = &cmd };
+		nosVulkan->Begin2(&beginParams);
+		nosVulkan->AddWaitSemaphoreToCmd(cmd, semaphore, 1);
+		nosGPUEvent acquired{};
+		nosCmdEndParams endParams = { .ForceSubmit = true, .OutGPUEventHandle = &acquired };
+		nosVulkan->End(cmd, &endParams);
+		PublishRenderTarget(imageIndex);
+		Timer->ScheduleNodeWhen(NodeId, [acquired]() mutable { return nosVulkan->WaitGpuEvent(&acquired, 0) == NOS_RESULT_SUCCESS; });
+		return true;
+	}
+
+	// Cleared whenever the published image is no longer acquired for upstream, e.g. when the swapchain is rebuilt
+	void PublishRenderTarget(std::optional<uint32_t> imageIndex)
+	{
+		RenderTargetPublished = imageIndex.has_value();
+		auto texture = imageIndex ? Swapchain.Images[*imageIndex] : nosResourceShareInfo{};
+		SetPinValue(NOS_NAME_STATIC("RenderTarget"), nos::Buffer::From(vkss::ConvertTextureInfo(texture)));
+	}
+
+	// Frames are tracked by their GPU event in submission order. Completion latency is measured from submission until the event
+	// is seen signalled. Events are only polled once per frame, so it is an upper bound of the GPU time, rounded up to the
+	// next ExecuteNode.
+	void TrackSubmittedFrame(nosGPUEvent gpuEvent)
+	{
+		if (InFlightFrameCount == InFlightFrames.size())
+			PollInFlightFrames(InFlightFrames[InFlightFrameHead].SubmitIndex);
+		InFlightFrames[(InFlightFrameHead + InFlightFrameCount++) % InFlightFrames.size()] = { gpuEvent, ++SubmittedFrames, util::Stopwatch() };
+	}
+
+	// Blocks until frame waitUntil has completed (0 to not block), then collects every other completed frame.
+	void PollInFlightFrames(uint64_t waitUntil)
+	{
+		while (InFlightFrameCount)
+		{
+			auto& frame = InFlightFrames[InFlightFrameHead];
+			if (frame.Event)
+			{
+				bool wait = frame.SubmitIndex <= waitUntil;
+				if (nosVulkan->WaitGpuEvent(&frame.Event, wait ? UINT64_MAX : 0) != NOS_RESULT_SUCCESS)
+					break;
+				StageStats.Add(PresentStage::Completion, std::chrono::duration_cast<std::chrono::nanoseconds>(frame.SinceSubmit.Elapsed()));
+			}
+			CompletedFrames = frame.SubmitIndex;
+			InFlightFrameHead = (InFlightFrameHead + 1) % InFlightFrames.size();
+			--InFlightFrameCount;
+		}
+		if (Swapchain.HasRetired())
+			Swapchain.ReleaseRetired(CompletedFrames);
+	}
+
+	void UpdateStatsPins(PacingClock::TimePoint now)
+	{
+		if (LastStatsPinUpdate && now - *LastStatsPinUpdate < std::chrono::seconds(1))
+			return;
+		LastStatsPinUpdate = now;
+		// Published once a second, in milliseconds
+		auto toMs = [](FramePacer::Duration d) { return std::chrono::duration<float, std::milli>(d).count(); };
+		SetPinValue(NOS_NAME_STATIC("FrameInterval"), nos::Buffer::From(toMs(Pacer.GetAchievedInterval())));
+		SetPinValue(NOS_NAME_STATIC("FrameJitter"), nos::Buffer::From(toMs(Pacer.GetJitter())));
+		SetPinValue(NOS_NAME_STATIC("DroppedFrames"), nos::Buffer::From(uint32_t(Inputs.Dropped)));
+		SetPinValue(NOS_NAME_STATIC("RepeatedFrames"), nos::Buffer::From(uint32_t(Inputs.Repeated)));
+		SetPinValue(NOS_NAME_STATIC("SwapchainRecreationsAvoided"), nos::Buffer::From(uint32_t(SwapchainRecreationsAvoided)));
+
+		static const nos::Name StagePinNames[] = {
+			NOS_NAME_STATIC("FrameWaitLatency"), NOS_NAME_STATIC("AcquireLatency"), NOS_NAME_STATIC("RecordLatency"), NOS_NAME_STATIC("SubmitLatency"),
+			NOS_NAME_STATIC("PresentLatency"), NOS_NAME_STATIC("CompletionLatency"), NOS_NAME_STATIC("FrameLatency"),
+			NOS_NAME_STATIC("RecreateLatency"), NOS_NAME_STATIC("MonitorEnumerationLatency")
+		};
+		std::string logLine;
+		for (uint32_t i = 0; i < uint32_t(PresentStage::Count); ++i)
+		{
+			auto summary = StageStats.Summarize(PresentStage(i));
+			SetPinValue(StagePinNames[i], nos::Buffer::From(nosVec4{ summary.P50, summary.P95, summary.P99, summary.Max }));
+			if (LogLatencyStats)
+				logLine += std::format(" | {}: {:.2f}/{:.2f}/{:.2f}/{:.2f}", GetPresentStageName(PresentStage(i)), summary.P50, summary.P95, summary.P99, summary.Max);
+		}
+		if (LogLatencyStats && ++StatsPublishCount % 5 == 0)
+			nosEngine.LogI("%s latency p50/p95/p99/max (ms)%s", GetWindowName().c_str(), logLine.c_str());
+	}
+
 	bool IsWindowLocked()
 	{
 		return CustomResolutionSet && Fullscreen;
@@ -612,77 +1193,130 @@ struct DisplayOutNode : NodeContext
 
 	void UpdateMonitorString()
 	{
-		std::string monitorStr = "NONE";
-		if (LockedMonitorPort)
-			monitorStr = PortToString(*LockedMonitorPort);
-		SetPinValue(NSN_Monitor, monitorStr.c_str());
-	}
-
-	std::string PortToString(GPUPortIdentifier port)
-	{
-		// Get windows adapter name
-		std::string displayDisplayName = "Unknown";
-		if (auto adapterName = CustomResolutionBase::Get()->GetAdapterName(port, GetPossibleAdapterNames()))
-			if(auto monitor = GetGLFWMonitorFromAdapterName(adapterName->c_str()))
-				displayDisplayName = glfwGetMonitorName(monitor);
-		return displayDisplayName + " - " + std::to_string((uint64_t)port.GPUId) + " - " + std::to_string(port.PortId);
+		if (!LockedMonitorPort)
+		{
+			SetPinValue(NSN_Monitor, "NONE");
+			return;
+		}
+		auto customRes = CustomResolutionBase::Get();
+		if (!customRes)
+			return;
+		// A locked monitor missing from the topology keeps its label, so the lock survives until it is connected again
+		auto topology = customRes->GetTopology();
+		if (auto entry = topology->FindByPort(*LockedMonitorPort))
+		{
+			LockedMonitorKey = entry->Key;
+			SetPinValue(NSN_Monitor, entry->Label.data());
+		}
 	}
 
-	std::optional<GPUPortIdentifier> GetPortFromString(const char* portString)
+	std::optional<GPUPortIdentifier> ResolveMonitorKey(MonitorKey key)
 	{
-		std::string str = portString;
-		// Go from the back to find the last '-'
-		size_t portIdStart = str.find_last_of(" - ");
-		if (portIdStart == std::string::npos)
-			return std::nullopt;
-		// Get the port id
-		std::string portIdStr = str.substr(portIdStart + 1);
-		std::stringstream ss(portIdStr);
-		uint32_t portId;
-		if(!(ss >> portId))
-			return std::nullopt;
-		// Get the GPU id
-		size_t gpuIdStart = str.find_last_of(" - ", portIdStart - 3);
-		if (gpuIdStart == std::string::npos)
-			return std::nullopt;
-		std::string gpuIdStr = str.substr(gpuIdStart + 1, portIdStart - 3 - gpuIdStart);
-		std::stringstream ss2(gpuIdStr);
-		uint64_t gpuId;
-		if (!(ss2 >> gpuId))
-			return std::nullopt;
-		return GPUPortIdentifier{ .GPUId = (void*)gpuId, .PortId = portId };
+		if (auto customRes = CustomResolutionBase::Get())
+		{
+			auto topology = customRes->GetTopology();
+			if (auto entry = topology->FindByKey(key))
+				return entry->Port;
+		}
+		return std::nullopt;
 	}
 
 	std::vector<std::string> GetPossibleMonitors()
 	{
-		auto activePorts = CustomResolutionBase::Get()->GetActivePortIds();
 		std::vector<std::string> monitors;
-		for (auto& port : activePorts)
-			monitors.push_back(PortToString(port));
+		if (auto customRes = CustomResolutionBase::Get())
+		{
+			auto topology = customRes->GetTopology();
+			for (auto& entry : topology->Entries)
+				monitors.push_back(entry.Label.data());
+		}
 		return monitors;
 	}
 
+	void UpdateMonitorList()
+	{
+		if (auto customRes = CustomResolutionBase::Get())
+			KnownTopologyGeneration = customRes->GetTopologyGeneration();
+		// GPU handles may change with the topology, the key does not
+		MonitorLost = false;
+		if (LockedMonitorKey)
+		{
+			if (auto port = ResolveMonitorKey(*LockedMonitorKey))
+				LockedMonitorPort = port;
+			else
+				MonitorLost = KnownTopologyGeneration != 0;
+		}
+		UpdateStringList(std::string("Monitor_") + UUID2STR(NodeId), GetPossibleMonitors());
+	}
+
+	std::shared_ptr<WindowRuntime> Runtime;
 	GLFWwindow* Window = nullptr;
-	std::vector<nosSemaphore> WaitSemaphore{};
-	std::vector<nosSemaphore> SignalSemaphore{};
-	std::vector<nosResourceShareInfo> Images{};
-	uint32_t FrameCount = 0;
+	WindowEventQueue WindowEvents;
+	PresentSwapchain Swapchain;
 	uint32_t CurrentFrame = 0;
-	nosSurfaceHandle Surface{};
-	nosSwapchainHandle Swapchain{};
+	uint32_t MaxFramesInFlight = 2;
+	std::unique_ptr<PresentBackend> Backend;
 
 	nosVec2u Resolution = { 1920, 1080 };
 	bool Fullscreen = false;
-	bool VSync = false;
+	nosPresentMode PresentMode = NOS_PRESENT_MODE_IMMEDIATE;
+	std::optional<nosPresentMode> ActivePresentMode;
+	PresentPassSettings PresentSettings;
+	InputPolicy Policy = InputPolicy::RepeatLast;
+	InputQueue Inputs;
+	uint64_t UpstreamFrame = 0;
+	bool WaitingForDeadline = false;
+	bool SwapchainNeedsFrame = false;
+	bool SwapchainDirty = false;
+	uint64_t SwapchainRecreationsAvoided = 0;
+	std::optional<util::Stopwatch> StartupWatch;
+	float AcquireTimeout = 100.0f; // In milliseconds
+	AcquireTimeoutPolicy TimeoutPolicy = AcquireTimeoutPolicy::Skip;
+	uint64_t AcquireTimeouts = 0;
+	bool AcquireStalled = false;
 	float RefreshRate = 60.0f;
 	bool ShowCursor = false;
+	bool FramePacing = false;
+	bool LogLatencyStats = false;
+	bool Headless = false;
+	bool ZeroCopy = false;
+	std::optional<uint32_t> AcquiredImage;
+	bool RenderTargetPublished = false;
 	std::optional<std::string> WindowName = std::nullopt;
 
 	uint32_t ColorDepth = 32;
 	nosFormat ColorFormat = NOS_FORMAT_B8G8R8A8_UNORM;
+	TimingStandard Standard = TimingStandard::Auto;
+	DisplayLink Link = DisplayLink::Unknown;
 
 	bool CustomResolutionSet = false;
 	std::optional<GPUPortIdentifier> LockedMonitorPort;
+	std::optional<MonitorKey> LockedMonitorKey;
+	uint64_t KnownTopologyGeneration = 0;
+
+	FramePacer Pacer{SteadyPacingClock::Get()};
+	FramePacer HeartbeatPacer{SteadyPacingClock::Get()};
+	std::shared_ptr<ScheduleTimer> Timer;
+	float HiddenHeartbeatRate = 4.0f;
+	bool Visible = true;
+	bool Iconified = false;
+	bool ZeroExtent = false;
+	bool MonitorLost = false;
+	std::optional<PacingClock::TimePoint> LastStatsPinUpdate;
+	uint64_t StatsPublishCount = 0;
+
+	PresentStageStats StageStats;
+	struct InFlightFrame
+	{
+		nosGPUEvent Event{};
+		uint64_t SubmitIndex = 0;
+		util::Stopwatch SinceSubmit;
+	};
+	std::array<InFlightFrame, 8> InFlightFrames{};
+	size_t InFlightFrameHead = 0;
+	size_t InFlightFrameCount = 0;
+	uint64_t SubmittedFrames = 0;
+	uint64_t CompletedFrames = 0;
 };
 
 nosResult RegisterDisplayOut(nosNodeFunctions* fn)
@@ -0,0 +1,584 @@
+#include "CustomResolutionBase.h"
+#include "PresentBackend.h"
+#include "PresentPass.h"
+#include "PresentSwapchain.h"
+#include "VideoWall.h"
+#include "WindowRuntime.h"
+
+#include <Nodos/PluginHelpers.hpp>
+#include <nosVulkanSubsystem/Helpers.hpp>
+
+#include <algorithm>
+
+#include "nosUtil/Stopwatch.hpp"
+#include "GLFW/glfw3.h"
+#if defined(WIN32)
+#define GLFW_EXPOSE_NATIVE_WIN32
+#elif defined(__linux)
+#define GLFW_EXPOSE_NATIVE_X11
+#else
+#error "Unsupported platform"
+#endif
+#include "GLFW/glfw3native.h"
+
+namespace nos::display
+{
+// One monitor of a DisplayOutMulti: a borderless window covering the monitor and its swapchain.
+struct MultiDisplayOutput
+{
+	static constexpr uint32_t MaxFramesInFlight = 2;
+
+	std::string Label;
+	GLFWwindow* Window = nullptr;
+	std::unique_ptr<WindowEventQueue> Events = std::make_unique<WindowEventQueue>(); // Referenced by the window runtime
+	std::unique_ptr<PresentBackend> Backend;
+	PresentSwapchain Swapchain;
+	nosVec2u MonitorExtent{}; // Monitor mode the window was opened at, zero when the monitor was not found
+	PresentPassSettings Settings;
+	bool SwapchainDirty = false;
+	std::optional<uint32_t> AcquiredImage; // Image recorded into the current frame
+	uint64_t PresentedFrames = 0;
+};
+
+// Presents its inputs on several monitors at once. Every output is recorded into one command buffer and submitted once,
+// but nos.sys.vulkan has no batched present: each swapchain gets a Present of its own, issued back to back after the
+// submit, so outputs can still flip on different vblanks.
+struct DisplayOutMultiNode : NodeContext
+{
+	static constexpr uint32_t MaxFramesInFlight = MultiDisplayOutput::MaxFramesInFlight;
+
+	DisplayOutMultiNode(const fb::Node* node) : NodeContext(node)
+	{
+		fb::TVisualizer visualizer;
+		visualizer.type = fb::VisualizerType::COMBO_BOX;
+		visualizer.name = GetMonitorListName();
+		SetPinVisualizer(NOS_NAME_STATIC("Monitors"), visualizer);
+		UpdateStringList(GetMonitorListName(), { "NONE" });
+		fb::TVisualizer presentModeVisualizer;
+		presentModeVisualizer.type = fb::VisualizerType::COMBO_BOX;
+		presentModeVisualizer.name = "nos.display.PresentMode";
+		SetPinVisualizer(NOS_NAME_STATIC("PresentMode"), presentModeVisualizer);
+		std::vector<std::string> presentModes;
+		for (auto& info : LatencyOrderedPresentModes)
+			presentModes.push_back(info.Name);
+		UpdateStringList(presentModeVisualizer.name, presentModes);
+	}
+
+	~DisplayOutMultiNode()
+	{
+		Clear();
+	}
+
+	std::string GetMonitorListName() const
+	{
+		return std::string("MonitorMulti_") + UUID2STR(NodeId);
+	}
+
+	void OnEnterRunnerThread(std::optional<nosUUID> runnerId) override
+	{
+		if (!runnerId)
+			return;
+		Runtime = WindowRuntime::Acquire();
+		if (!Runtime)
+			return;
+		UpdateMonitorList();
+		OpenOutputs();
+	}
+
+	void OnExitRunnerThread(std::optional<nosUUID> runnerId) override
+	{
+		if (!runnerId)
+			return;
+		Clear();
+	}
+
+	void OnPathStart() override
+	{
+		nosScheduleNodeParams params = {};
+		params.NodeId = NodeId;
+		params.Reset = false;
+		params.AddScheduleCount = 1;
+		nosEngine.ScheduleNode(&params);
+	}
+
+	void OnPathStop() override
+	{
+		WaitForFrames();
+	}
+
+	void OnPinValueChanged(nos::Name pinName, nosUUID pinId, nosBuffer value) override
+	{
+		if (pinName == NOS_NAME_STATIC("Monitors"))
+		{
+			std::vector<std::string> labels;
+			if (auto monitors = flatbuffers::GetRoot<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>>(value.Data))
+				for (auto label : *monitors)
+					labels.push_back(label->str());
+			if (labels == MonitorLabels)
+				return;
+			MonitorLabels = std::move(labels);
+			// Windows are only touched on the runner thread
+			OutputsDirty = true;
+		}
+		else if (pinName == NOS_NAME_STATIC("PresentMode"))
+		{
+			auto presentMode = ParsePresentMode(InterpretPinValue<const char>(value));
+			if (!presentMode)
+			{
+				nosEngine.LogE("Unknown present mode: %s", InterpretPinValue<const char>(value));
+				return;
+			}
+			PresentMode = *presentMode;
+			for (auto& output : Outputs)
+				output.SwapchainDirty = true;
+		}
+		else if (pinName == NOS_NAME_STATIC("AcquireTimeout"))
+		{
+			AcquireTimeout = std::max(*InterpretPinValue<float>(value), 0.0f);
+		}
+		else if (pinName == NOS_NAME_STATIC("MonitorResolution"))
+		{
+			MonitorResolution = *InterpretPinValue<nosVec2u>(value);
+			OutputsDirty = true;
+		}
+		else if (pinName == NOS_NAME_STATIC("MonitorRefreshRate"))
+		{
+			MonitorRefreshRate = *InterpretPinValue<float>(value);
+			OutputsDirty = true;
+		}
+		else if (pinName == NOS_NAME_STATIC("Span"))
+		{
+			Span = *InterpretPinValue<bool>(value);
+			LayoutDirty = true;
+		}
+		else if (pinName == NOS_NAME_STATIC("Columns"))
+		{
+			Columns = std::max(*InterpretPinValue<uint32_t>(value), 1u);
+			LayoutDirty = true;
+		}
+		else if (pinName == NOS_NAME_STATIC("Bezel"))
+		{
+			Bezel = *InterpretPinValue<nosVec2u>(value);
+			LayoutDirty = true;
+		}
+		else if (pinName == NOS_NAME_STATIC("TileOffsets"))
+		{
+			TileOffsets.clear();
+			if (auto offsets = flatbuffers::GetRoot<flatbuffers::Vector<const fb::vec2i*>>(value.Data))
+				for (auto offset : *offsets)
+					TileOffsets.push_back({ offset->x(), offset->y() });
+			LayoutDirty = true;
+		}
+		else if (pinName == NOS_NAME_STATIC("TileRotations"))
+		{
+			TileRotations.clear();
+			if (auto rotations = flatbuffers::GetRoot<flatbuffers::Vector<uint32_t>>(value.Data))
+				for (auto degrees : *rotations)
+				{
+					if (degrees % 90)
+						nosEngine.LogW("%s: Tile rotation of %u degrees is rounded down to a quarter turn", GetDisplayName().c_str(), degrees);
+					TileRotations.push_back(PresentRotation(degrees / 90 % 4));
+				}
+			LayoutDirty = true;
+		}
+	}
+
+	nosResult ExecuteNode(nosNodeExecuteParams* params) override
+	{
+		if (!Runtime)
+			return NOS_RESULT_FAILED;
+		nosScheduleNodeParams scheduleParams = {};
+		scheduleParams.NodeId = NodeId;
+		scheduleParams.Reset = false;
+		scheduleParams.AddScheduleCount = 1;
+
+		nos::NodeExecuteParams execParams = params;
+		std::vector<nosResourceShareInfo> inputs;
+		if (auto textures = flatbuffers::GetRoot<flatbuffers::Vector<flatbuffers::Offset<sys::vulkan::Texture>>>(execParams[NOS_NAME_STATIC("Inputs")].Data->Data))
+			for (auto texture : *textures)
+				inputs.push_back(vkss::ConvertToResourceInfo(*texture));
+		std::erase_if(inputs, [](nosResourceShareInfo const& input) { return !input.Memory.Handle; });
+		if (inputs.empty())
+			return NOS_RESULT_FAILED;
+
+		if (OutputsDirty)
+		{
+			CloseOutputs();
+			OpenOutputs();
+		}
+		ProcessWindowEvents();
+
+		// Frame slots are shared by every output, waiting for one covers all swapchains
+		uint32_t slot = SubmittedFrames % MaxFramesInFlight;
+		WaitForSlot(slot);
+		for (auto& output : Outputs)
+			if (output.Window && (output.SwapchainDirty || !output.Backend->HasSwapchain()))
+				RecreateSwapchain(output);
+		if (LayoutDirty)
+			UpdateLayout();
+
+		// Every output is recorded into one command buffer and submitted once
+		nosCmd cmd;
+		nosCmdBeginParams beginParams = { .Name = NOS_NAME_STATIC("DisplayOutMulti"), .AssociatedNodeId = NodeId, .OutCmdHandle = &cmd };
+		nosVulkan->Begin2(&beginParams);
+		// Outputs are acquired one after the other against one deadline, stalled outputs do not add up their timeouts
+		auto acquireDeadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<float, std::milli>(AcquireTimeout));
+		for (size_t i = 0; i < Outputs.size(); ++i)
+		{
+			auto& output = Outputs[i];
+			if (!output.Backend || !output.Backend->HasSwapchain())
+				continue;
+			auto timeout = std::max(std::chrono::duration_cast<std::chrono::nanoseconds>(acquireDeadline - std::chrono::steady_clock::now()), std::chrono::nanoseconds(0));
+			uint32_t imageIndex;
+			auto result = output.Backend->AcquireNextImage(uint64_t(timeout.count()), &imageIndex, output.Swapchain.AcquireSemaphores[slot]);
+			if (result != NOS_RESULT_SUCCESS)
+			{
+				// A stalled output skips the frame, the others go on
+				if (result != NOS_RESULT_TIMEOUT)
+					output.SwapchainDirty = true;
+				continue;
+			}
+			// Spanning outputs each show their part of the first input, others without an input of their own show the last one
+			auto& input = Span ? inputs.front() : inputs[std::min(i, inputs.size() - 1)];
+			auto& image = output.Swapchain.Images[imageIndex];
+			RecordPresentPass(cmd, input, image, output.Settings);
+			nosVulkan->ImageStateToPresent(cmd, &image);
+			nosVulkan->AddWaitSemaphoreToCmd(cmd, output.Swapchain.AcquireSemaphores[slot], 1);
+			nosVulkan->AddSignalSemaphoreToCmd(cmd, output.Swapchain.PresentSemaphores[imageIndex], 1);
+			output.AcquiredImage = imageIndex;
+		}
+		nosCmdEndParams endParams{ .ForceSubmit = true, .OutGPUEventHandle = &SlotEvents[slot] };
+		nosVulkan->End(cmd, &endParams);
+		++SubmittedFrames;
+
+		// nos.sys.vulkan presents one swapchain per call, presents are issued back to back right after the single submit
+		for (auto& output : Outputs)
+		{
+			if (!output.AcquiredImage)
+				continue;
+			uint32_t imageIndex = *std::exchange(output.AcquiredImage, std::nullopt);
+			if (output.Backend->Present(imageIndex, output.Swapchain.PresentSemaphores[imageIndex]) == NOS_RESULT_SUCCESS)
+				++output.PresentedFrames;
+			else
+				output.SwapchainDirty = true;
+		}
+		UpdateFrameCounterPins();
+		nosEngine.ScheduleNode(&scheduleParams);
+		return NOS_RESULT_SUCCESS;
+	}
+
+	void ProcessWindowEvents()
+	{
+		bool monitorsChanged = false;
+		for (auto& output : Outputs)
+		{
+			WindowEvent event;
+			while (output.Window && output.Events->Pop(event))
+			{
+				switch (event.Type)
+				{
+				case WindowEventType::Resized:
+					if (event.X && event.Y && (output.Swapchain.Extent.x != uint32_t(event.X) || output.Swapchain.Extent.y != uint32_t(event.Y)))
+						output.SwapchainDirty = true;
+					break;
+				case WindowEventType::CloseRequested: CloseOutput(output); break;
+				case WindowEventType::MonitorsChanged: monitorsChanged = true; break;
+				default: break;
+				}
+			}
+		}
+		if (monitorsChanged)
+			UpdateMonitorList();
+	}
+
+	void OpenOutputs()
+	{
+		OutputsDirty = false;
+		auto customRes = CustomResolutionBase::Get();
+		auto topology = customRes ? customRes->GetTopology() : nullptr;
+		std::vector<const DisplayTopologyEntry*> entries;
+		std::vector<GPUPortIdentifier> ports;
+		for (auto& label : MonitorLabels)
+		{
+			auto key = ParseMonitorLabel(label);
+			auto entry = key && topology ? topology->FindByKey(*key) : nullptr;
+			if (entry && entry->Monitor)
+				ports.push_back(entry->Port);
+			else
+				nosEngine.LogW("%s: Monitor not found: %s", GetDisplayName().c_str(), label.c_str());
+			entries.push_back(entry && entry->Monitor ? entry : nullptr);
+		}
+		// Before the windows are opened, they cover the monitors in their new modes
+		UpdateMonitorModes(ports);
+		Outputs.resize(MonitorLabels.size());
+		LayoutDirty = true;
+		for (size_t i = 0; i < MonitorLabels.size(); ++i)
+		{
+			auto& output = Outputs[i];
+			output.Label = MonitorLabels[i];
+			auto entry = entries[i];
+			if (!entry)
+				continue;
+			auto monitor = (GLFWmonitor*)entry->Monitor;
+			auto geometry = Runtime->Invoke([monitor] {
+				WindowGeometry geometry{ .Decorated = false };
+				int monitorPosX, monitorPosY;
+				glfwGetMonitorPos(monitor, &monitorPosX, &monitorPosY);
+				geometry.Position = nosVec2i{ monitorPosX, monitorPosY };
+				auto mode = glfwGetVideoMode(monitor);
+				geometry.Size = { uint32_t(mode->width), uint32_t(mode->height) };
+				return geometry;
+			});
+			output.MonitorExtent = geometry.Size;
+			output.Window = Runtime->OpenWindow(geometry, GetDisplayName() + " - " + output.Label, output.Events.get());
+			if (!output.Window)
+				continue;
+			Runtime->Post([window = output.Window] { glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN); });
+			output.Backend = CreateVulkanPresentBackend();
+			auto windowHandle =
+#if defined(WIN32)
+				glfwGetWin32Window(output.Window)
+#elif defined(__linux)
+				glfwGetX11Window(output.Window)
+#else
+#error "Unsupported platform"
+#endif
+				;
+			if (!output.Backend->CreateSurface((void*)windowHandle))
+				CloseOutput(output);
+			else
+				output.SwapchainDirty = true;
+		}
+	}
+
+	// Spanning reads each tile straight from the input in the present pass, no cropped copies of the input are made
+	void UpdateLayout()
+	{
+		LayoutDirty = false;
+		std::vector<WallTile> tiles(Outputs.size());
+		for (size_t i = 0; i < Outputs.size(); ++i)
+		{
+			// Outputs without a swapchain keep the place of their monitor so that the tiles after them do not move
+			auto& output = Outputs[i];
+			tiles[i].Extent = output.Backend && output.Backend->HasSwapchain() ? output.Swapchain.Extent : output.MonitorExtent;
+			if (i < TileOffsets.size())
+				tiles[i].Offset = TileOffsets[i];
+			if (i < TileRotations.size())
+				tiles[i].Rotation = TileRotations[i];
+		}
+		auto rects = ComputeWallLayout(tiles, Columns, Bezel);
+		for (size_t i = 0; i < Outputs.size(); ++i)
+		{
+			auto& settings = Outputs[i].Settings;
+			settings = PresentSettings;
+			settings.Rotation = tiles[i].Rotation;
+			if (Span)
+				settings.SourceRect = rects[i];
+		}
+	}
+
+	void RecreateSwapchain(MultiDisplayOutput& output)
+	{
+		output.SwapchainDirty = false;
+		LayoutDirty = true;
+		RetireSwapchain(output);
+		auto extent = Runtime->Invoke([window = output.Window] {
+			int width, height;
+			glfwGetWindowSize(window, &width, &height);
+			return nosVec2u{ uint32_t(width), uint32_t(height) };
+		});
+		if (!output.Swapchain.Create(*output.Backend, extent, PresentMode, MaxFramesInFlight))
+			nosEngine.LogE("%s: Failed to create swapchain for %s", GetDisplayName().c_str(), output.Label.c_str());
+	}
+
+	// Nothing is waited for, the swapchain and its semaphores are released once this node's frames that use them and the
+	// presents after them have completed
+	void RetireSwapchain(MultiDisplayOutput& output)
+	{
+		if (!output.Backend || !output.Backend->HasSwapchain())
+			return;
+		output.Swapchain.Retire(SubmittedFrames + output.Swapchain.GetImageCount());
+		output.AcquiredImage = std::nullopt;
+	}
+
+	void ReleaseRetiredSwapchains(uint64_t completedFrames)
+	{
+		for (auto& output : Outputs)
+			output.Swapchain.ReleaseRetired(completedFrames);
+	}
+
+	void WaitForSlot(uint32_t slot)
+	{
+		if (SlotEvents[slot])
+		{
+			nosVulkan->WaitGpuEvent(&SlotEvents[slot], UINT64_MAX);
+			SlotEvents[slot] = {};
+		}
+		if (SubmittedFrames >= MaxFramesInFlight)
+			CompletedFrames = std::max(CompletedFrames, SubmittedFrames - MaxFramesInFlight + 1);
+		ReleaseRetiredSwapchains(CompletedFrames);
+	}
+
+	void WaitForFrames()
+	{
+		for (auto& event : SlotEvents)
+		{
+			if (!event)
+				continue;
+			nosVulkan->WaitGpuEvent(&event, UINT64_MAX);
+			event = {};
+		}
+		CompletedFrames = SubmittedFrames;
+	}
+
+	// A swapchain has to be released before its surface, pending presents are done with it once the queue is flushed
+	void CloseOutput(MultiDisplayOutput& output)
+	{
+		LayoutDirty = true;
+		if (output.Backend)
+		{
+			RetireSwapchain(output);
+			if (output.Swapchain.HasRetired())
+			{
+				FlushQueue();
+				output.Swapchain.ReleaseAllRetired();
+			}
+			output.Backend->DestroySurface();
+		}
+		if (output.Window)
+		{
+			Runtime->ReleaseWindow(output.Window);
+			output.Window = nullptr;
+		}
+	}
+
+	// Flushes the queue once for every output instead of once per output
+	void CloseOutputs()
+	{
+		for (auto& output : Outputs)
+			RetireSwapchain(output);
+		if (std::any_of(Outputs.begin(), Outputs.end(), [](MultiDisplayOutput const& output) { return output.Swapchain.HasRetired(); }))
+			FlushQueue();
+		ReleaseRetiredSwapchains(UINT64_MAX);
+		for (auto& output : Outputs)
+			CloseOutput(output);
+		Outputs.clear();
+	}
+
+	void FlushQueue()
+	{
+		nosCmd cmd;
+		nosCmdBeginParams beginParams = { .Name = NOS_NAME_STATIC("DisplayOutMulti flush cmd"), .AssociatedNodeId = NodeId, .OutCmdHandle = &cmd };
+		nosVulkan->Begin2(&beginParams);
+		nosGPUEvent wait;
+		nosCmdEndParams endParams = { .ForceSubmit = true, .OutGPUEventHandle = &wait };
+		nosVulkan->End(cmd, &endParams);
+		nosVulkan->WaitGpuEvent(&wait, UINT64_MAX);
+		WaitForFrames();
+	}
+
+	// Monitors of a wall switch in one custom resolution transaction and resync together. Monitors dropped from the node,
+	// or all of them when MonitorResolution is zero, go back to their own modes.
+	void UpdateMonitorModes(std::vector<GPUPortIdentifier> const& ports)
+	{
+		auto customRes = CustomResolutionBase::Get();
+		if (!customRes)
+			return;
+		bool enabled = MonitorResolution.x && MonitorResolution.y;
+		std::vector<GPUPortIdentifier> kept, dropped;
+		for (auto& port : CustomModePorts)
+			(enabled && std::find(ports.begin(), ports.end(), port) != ports.end() ? kept : dropped).push_back(port);
+		if (!dropped.empty())
+			customRes->RevertResolutions(dropped);
+		CustomModePorts = std::move(kept);
+		if (!enabled)
+			return;
+		std::vector<CustomResolutionRequest> requests;
+		for (auto& port : ports)
+		{
+			// Monitors already in the mode are not switched again
+			auto applied = customRes->GetAppliedResolution(port);
+			if (applied && applied->Resolution.x == MonitorResolution.x && applied->Resolution.y == MonitorResolution.y && applied->RefreshRate == MonitorRefreshRate)
+				continue;
+			requests.push_back({ .Port = port, .Info = { .Resolution = MonitorResolution, .RefreshRate = MonitorRefreshRate } });
+		}
+		if (requests.empty())
+			return;
+		if (!customRes->SetResolutionsAndRefreshRates(requests))
+		{
+			nosEngine.LogE("%s: Failed to set %ux%u@%.3f, no monitor was changed", GetDisplayName().c_str(), MonitorResolution.x, MonitorResolution.y,
+						   MonitorRefreshRate);
+			return;
+		}
+		CustomModePorts = ports;
+	}
+
+	void Clear()
+	{
+		CloseOutputs();
+		UpdateMonitorModes({});
+		Runtime.reset();
+	}
+
+	void UpdateMonitorList()
+	{
+		std::vector<std::string> monitors;
+		if (auto customRes = CustomResolutionBase::Get())
+		{
+			auto topology = customRes->GetTopology();
+			for (auto& entry : topology->Entries)
+				monitors.push_back(entry.Label.data());
+		}
+		UpdateStringList(GetMonitorListName(), monitors);
+	}
+
+	// Published once a second. Presented frame counts of outputs that run in step stay equal, FrameSkew is the largest difference.
+	void UpdateFrameCounterPins()
+	{
+		if (LastCounterUpdate.Elapsed() < std::chrono::seconds(1))
+			return;
+		LastCounterUpdate = {};
+		std::vector<uint64_t> counters;
+		for (auto& output : Outputs)
+			counters.push_back(output.PresentedFrames);
+		uint64_t skew = 0;
+		if (!counters.empty())
+		{
+			auto [min, max] = std::minmax_element(counters.begin(), counters.end());
+			skew = *max - *min;
+		}
+		flatbuffers::FlatBufferBuilder fbb;
+		fbb.Finish(fbb.CreateVector(counters));
+		SetPinValue(NOS_NAME_STATIC("PresentedFrames"), nos::Buffer(fbb.GetBufferPointer(), fbb.GetSize()));
+		SetPinValue(NOS_NAME_STATIC("FrameSkew"), nos::Buffer::From(skew));
+	}
+
+	std::shared_ptr<WindowRuntime> Runtime;
+	std::vector<std::string> MonitorLabels;
+	std::vector<MultiDisplayOutput> Outputs;
+	bool OutputsDirty = false;
+	nosVec2u MonitorResolution{}; // Zero keeps the modes the monitors run
+	float MonitorRefreshRate = 60.0f;
+	std::vector<GPUPortIdentifier> CustomModePorts;
+	nosPresentMode PresentMode = NOS_PRESENT_MODE_IMMEDIATE;
+	float AcquireTimeout = 100.0f; // In milliseconds
+	PresentPassSettings PresentSettings{ .Letterbox = true };
+	bool Span = false;
+	uint32_t Columns = 1;
+	nosVec2u Bezel{};
+	std::vector<nosVec2i> TileOffsets;
+	std::vector<PresentRotation> TileRotations;
+	bool LayoutDirty = true;
+
+	std::array<nosGPUEvent, MaxFramesInFlight> SlotEvents{};
+	uint64_t SubmittedFrames = 0;
+	uint64_t CompletedFrames = 0;
+	util::Stopwatch LastCounterUpdate;
+};
+
+nosResult RegisterDisplayOutMulti(nosNodeFunctions* fn)
+{
+	NOS_BIND_NODE_CLASS(NOS_NAME_STATIC("DisplayOutMulti"), DisplayOutMultiNode, fn);
+	return NOS_RESULT_SUCCESS;
+}
+}
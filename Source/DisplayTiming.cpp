@@ -0,0 +1,294 @@
+#include "DisplayTiming.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace nos::display
+{
+namespace
+{
+constexpr uint32_t CellGranularity = 8;
+
+// std::floor is not constexpr before C++23
+constexpr double Floor(double value)
+{
+	auto truncated = double(int64_t(value));
+	return truncated > value ? truncated - 1 : truncated;
+}
+
+// Vertical sync width tells the aspect ratio apart, 10 stands for any non-standard ratio
+uint32_t GetCVTVSyncWidth(uint32_t width, uint32_t height)
+{
+	struct AspectRatio
+	{
+		uint32_t X, Y, VSync;
+	};
+	constexpr AspectRatio ratios[] = { { 4, 3, 4 }, { 16, 9, 5 }, { 16, 10, 6 }, { 5, 4, 7 }, { 15, 9, 7 } };
+	for (auto& ratio : ratios)
+		if (height == (width * ratio.Y / ratio.X / CellGranularity) * CellGranularity || height * ratio.X == width * ratio.Y)
+			return ratio.VSync;
+	return 10;
+}
+
+constexpr std::optional<DisplayTiming> CVTReducedBlankingV2(uint32_t width, uint32_t height, double refreshRate)
+{
+	constexpr double MinVBlank = 460.0; // In microseconds
+	constexpr uint32_t HBlank = 80, HSync = 32, HFrontPorch = 8;
+	constexpr uint32_t MinVFrontPorch = 1, VSync = 8, VBackPorch = 6;
+
+	if (!width || !height || refreshRate <= 0)
+		return std::nullopt;
+	double hPeriodEstimate = (1000000.0 / refreshRate - MinVBlank) / height;
+	if (hPeriodEstimate <= 0)
+		return std::nullopt;
+	uint32_t vBlank = std::max(uint32_t(MinVBlank / hPeriodEstimate) + 1, MinVFrontPorch + VSync + VBackPorch);
+	uint32_t hTotal = width + HBlank;
+	uint32_t vTotal = height + vBlank;
+	// 1 kHz steps, the epsilon keeps exact products from flooring one step down
+	double pixelClockKHz = Floor(refreshRate * vTotal * hTotal / 1000.0 + 1e-6);
+
+	DisplayTiming timing;
+	timing.HActive = width;
+	timing.HFrontPorch = HFrontPorch;
+	timing.HSync = HSync;
+	timing.HBackPorch = HBlank - HFrontPorch - HSync;
+	timing.VActive = height;
+	timing.VFrontPorch = vBlank - VSync - VBackPorch;
+	timing.VSync = VSync;
+	timing.VBackPorch = VBackPorch;
+	timing.PixelClock = uint64_t(pixelClockKHz) * 1000;
+	timing.HSyncPositive = true;
+	timing.VSyncPositive = false;
+	return timing;
+}
+
+struct BroadcastTiming
+{
+	double RefreshRate;
+	DisplayTiming Timing;
+};
+
+struct BroadcastResolution
+{
+	uint32_t Width, Height;
+};
+
+struct BroadcastRate
+{
+	uint32_t Rate;
+	bool HasFractional; // Also used at Rate * 1000 / 1001
+};
+
+constexpr BroadcastResolution BroadcastResolutions[] = { { 1280, 720 }, { 1920, 1080 }, { 2560, 1440 }, { 3840, 2160 }, { 4096, 2160 } };
+constexpr BroadcastRate BroadcastRates[] = { { 24, true }, { 25, false }, { 30, true }, { 48, true }, { 50, false }, { 60, true }, { 100, false }, { 120, true } };
+
+constexpr size_t GetBroadcastTimingCount()
+{
+	size_t count = 0;
+	for (auto& rate : BroadcastRates)
+		count += rate.HasFractional ? 2 : 1;
+	return count * std::size(BroadcastResolutions);
+}
+
+// Blanking of the integer rate, pixel clock of exactly total pixels times the rate (times 1000/1001, rounded to 1 Hz)
+constexpr auto BroadcastTimings = [] {
+	std::array<BroadcastTiming, GetBroadcastTimingCount()> table{};
+	size_t i = 0;
+	for (auto& resolution : BroadcastResolutions)
+	{
+		for (auto& rate : BroadcastRates)
+		{
+			auto timing = *CVTReducedBlankingV2(resolution.Width, resolution.Height, rate.Rate);
+			uint64_t totalPixels = uint64_t(timing.HTotal()) * timing.VTotal();
+			timing.PixelClock = totalPixels * rate.Rate;
+			table[i++] = { double(rate.Rate), timing };
+			if (!rate.HasFractional)
+				continue;
+			timing.PixelClock = (totalPixels * rate.Rate * 1000 + 500) / 1001;
+			table[i++] = { rate.Rate * 1000.0 / 1001.0, timing };
+		}
+	}
+	return table;
+}();
+static_assert(BroadcastTimings.back().Timing.PixelClock != 0, "Every broadcast timing is filled");
+
+struct LinkRate
+{
+	DisplayLink Link;
+	double PayloadBitsPerSecond; // After line coding
+};
+
+constexpr LinkRate LinkRates[] = {
+	{ DisplayLink::DVI, 165e6 * 24 },		   // Single link TMDS
+	{ DisplayLink::HDMI14, 340e6 * 24 },	   // TMDS
+	{ DisplayLink::HDMI20, 600e6 * 24 },	   // TMDS
+	{ DisplayLink::HDMI21, 48e9 * 16 / 18 },   // FRL, 4 lanes of 12 Gbps
+	{ DisplayLink::DisplayPort12, 4 * 5.4e9 * 0.8 },   // HBR2, 8b/10b
+	{ DisplayLink::DisplayPort14, 4 * 8.1e9 * 0.8 },   // HBR3, 8b/10b
+	{ DisplayLink::DisplayPort20, 4 * 20e9 * 128 / 132 }, // UHBR20, 128b/132b
+};
+}
+
+std::optional<TimingStandard> ParseTimingStandard(std::string_view name)
+{
+	for (uint32_t i = 0; i < std::size(TimingStandardNames); ++i)
+		if (name == TimingStandardNames[i])
+			return TimingStandard(i);
+	return std::nullopt;
+}
+
+std::optional<DisplayLink> ParseDisplayLink(std::string_view name)
+{
+	for (uint32_t i = 0; i < std::size(DisplayLinkNames); ++i)
+		if (name == DisplayLinkNames[i])
+			return DisplayLink(i);
+	return std::nullopt;
+}
+
+uint64_t GetMaxPixelClock(DisplayLink link, uint32_t bitsPerPixel)
+{
+	if (!bitsPerPixel)
+		return 0;
+	for (auto& rate : LinkRates)
+		if (rate.Link == link)
+			return uint64_t(rate.PayloadBitsPerSecond / bitsPerPixel);
+	return 0;
+}
+
+std::optional<DisplayTiming> ComputeCVTTiming(uint32_t width, uint32_t height, double refreshRate)
+{
+	constexpr double MinVSyncBackPorch = 550.0; // In microseconds
+	constexpr uint32_t VFrontPorch = 3, MinVBackPorch = 6;
+	constexpr double CPrime = 30.0, MPrime = 300.0, HSyncPercent = 8.0;
+	constexpr double ClockStep = 0.25; // In MHz
+
+	width = width / CellGranularity * CellGranularity;
+	if (!width || !height || refreshRate <= 0)
+		return std::nullopt;
+	double hPeriodEstimate = (1000000.0 / refreshRate - MinVSyncBackPorch) / (height + VFrontPorch);
+	if (hPeriodEstimate <= 0)
+		return std::nullopt;
+	uint32_t vSync = GetCVTVSyncWidth(width, height);
+	uint32_t vSyncBackPorch = std::max(uint32_t(MinVSyncBackPorch / hPeriodEstimate) + 1, vSync + MinVBackPorch);
+	double idealDutyCycle = std::max(CPrime - MPrime * hPeriodEstimate / 1000.0, 20.0);
+	uint32_t hBlank = uint32_t(width * idealDutyCycle / (100.0 - idealDutyCycle) / (2 * CellGranularity)) * 2 * CellGranularity;
+	uint32_t hTotal = width + hBlank;
+	double pixelClock = ClockStep * std::floor(hTotal / hPeriodEstimate / ClockStep);
+	uint32_t hSync = uint32_t(HSyncPercent / 100.0 * hTotal / CellGranularity) * CellGranularity;
+
+	DisplayTiming timing;
+	timing.HActive = width;
+	timing.HBackPorch = hBlank / 2;
+	timing.HSync = hSync;
+	timing.HFrontPorch = hBlank - hSync - hBlank / 2;
+	timing.VActive = height;
+	timing.VFrontPorch = VFrontPorch;
+	timing.VSync = vSync;
+	timing.VBackPorch = vSyncBackPorch - vSync;
+	timing.PixelClock = uint64_t(std::llround(pixelClock * 1000000.0));
+	timing.HSyncPositive = false;
+	timing.VSyncPositive = true;
+	return timing;
+}
+
+std::optional<DisplayTiming> ComputeCVTReducedBlankingTiming(uint32_t width, uint32_t height, double refreshRate)
+{
+	constexpr double MinVBlank = 460.0; // In microseconds
+	constexpr uint32_t HBlank = 160, HSync = 32, HFrontPorch = 48;
+	constexpr uint32_t VFrontPorch = 3, MinVBackPorch = 6;
+	constexpr double ClockStep = 0.25; // In MHz
+
+	width = width / CellGranularity * CellGranularity;
+	if (!width || !height || refreshRate <= 0)
+		return std::nullopt;
+	double hPeriodEstimate = (1000000.0 / refreshRate - MinVBlank) / height;
+	if (hPeriodEstimate <= 0)
+		return std::nullopt;
+	uint32_t vSync = GetCVTVSyncWidth(width, height);
+	uint32_t vBlank = std::max(uint32_t(MinVBlank / hPeriodEstimate) + 1, VFrontPorch + vSync + MinVBackPorch);
+	uint32_t hTotal = width + HBlank;
+	uint32_t vTotal = height + vBlank;
+	double pixelClock = ClockStep * std::floor(refreshRate * vTotal * hTotal / 1000000.0 / ClockStep);
+
+	DisplayTiming timing;
+	timing.HActive = width;
+	timing.HFrontPorch = HFrontPorch;
+	timing.HSync = HSync;
+	timing.HBackPorch = HBlank - HFrontPorch - HSync;
+	timing.VActive = height;
+	timing.VFrontPorch = VFrontPorch;
+	timing.VSync = vSync;
+	timing.VBackPorch = vBlank - VFrontPorch - vSync;
+	timing.PixelClock = uint64_t(std::llround(pixelClock * 1000000.0));
+	timing.HSyncPositive = true;
+	timing.VSyncPositive = false;
+	return timing;
+}
+
+std::optional<DisplayTiming> ComputeCVTReducedBlankingV2Timing(uint32_t width, uint32_t height, double refreshRate)
+{
+	return CVTReducedBlankingV2(width, height, refreshRate);
+}
+
+std::optional<DisplayTiming> ComputeGTFTiming(uint32_t width, uint32_t height, double refreshRate)
+{
+	constexpr double MinVSyncBackPorch = 550.0; // In microseconds
+	constexpr uint32_t VFrontPorch = 1, VSync = 3;
+	constexpr double CPrime = 30.0, MPrime = 300.0, HSyncPercent = 8.0;
+
+	width = uint32_t(std::round(double(width) / CellGranularity)) * CellGranularity;
+	if (!width || !height || refreshRate <= 0)
+		return std::nullopt;
+	double hPeriodEstimate = (1000000.0 / refreshRate - MinVSyncBackPorch) / (height + VFrontPorch);
+	if (hPeriodEstimate <= 0)
+		return std::nullopt;
+	uint32_t vSyncBackPorch = uint32_t(std::round(MinVSyncBackPorch / hPeriodEstimate));
+	uint32_t vTotal = height + vSyncBackPorch + VFrontPorch;
+	double refreshEstimate = 1000000.0 / hPeriodEstimate / vTotal;
+	double hPeriod = hPeriodEstimate / (refreshRate / refreshEstimate);
+	double idealDutyCycle = CPrime - MPrime * hPeriod / 1000.0;
+	uint32_t hBlank = uint32_t(std::round(width * idealDutyCycle / (100.0 - idealDutyCycle) / (2 * CellGranularity))) * 2 * CellGranularity;
+	uint32_t hTotal = width + hBlank;
+	double pixelClock = hTotal / hPeriod; // In MHz
+	uint32_t hSync = uint32_t(std::round(HSyncPercent / 100.0 * hTotal / CellGranularity)) * CellGranularity;
+
+	DisplayTiming timing;
+	timing.HActive = width;
+	timing.HBackPorch = hBlank / 2;
+	timing.HSync = hSync;
+	timing.HFrontPorch = hBlank / 2 - hSync;
+	timing.VActive = height;
+	timing.VFrontPorch = VFrontPorch;
+	timing.VSync = VSync;
+	timing.VBackPorch = vSyncBackPorch - VSync;
+	timing.PixelClock = uint64_t(std::llround(pixelClock * 1000000.0));
+	timing.HSyncPositive = false;
+	timing.VSyncPositive = true;
+	return timing;
+}
+
+std::optional<DisplayTiming> FindBroadcastTiming(uint32_t width, uint32_t height, double refreshRate)
+{
+	for (auto& entry : BroadcastTimings)
+		if (entry.Timing.HActive == width && entry.Timing.VActive == height && std::abs(entry.RefreshRate - refreshRate) < 0.001)
+			return entry.Timing;
+	return std::nullopt;
+}
+
+std::optional<DisplayTiming> ComputeTiming(TimingStandard standard, uint32_t width, uint32_t height, double refreshRate)
+{
+	switch (standard)
+	{
+	case TimingStandard::CVT: return ComputeCVTTiming(width, height, refreshRate);
+	case TimingStandard::CVTReducedBlanking: return ComputeCVTReducedBlankingTiming(width, height, refreshRate);
+	case TimingStandard::GTF: return ComputeGTFTiming(width, height, refreshRate);
+	case TimingStandard::Auto:
+	case TimingStandard::CVTReducedBlankingV2:
+		if (auto timing = FindBroadcastTiming(width, height, refreshRate))
+			return timing;
+		return ComputeCVTReducedBlankingV2Timing(width, height, refreshRate);
+	}
+	return std::nullopt;
+}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace nos::display
+{
+// Video timing of one progressive mode
+struct DisplayTiming
+{
+	uint32_t HActive = 0, HFrontPorch = 0, HSync = 0, HBackPorch = 0;
+	uint32_t VActive = 0, VFrontPorch = 0, VSync = 0, VBackPorch = 0;
+	uint64_t PixelClock = 0; // In Hz
+	bool HSyncPositive = false;
+	bool VSyncPositive = false;
+
+	constexpr uint32_t HTotal() const { return HActive + HFrontPorch + HSync + HBackPorch; }
+	constexpr uint32_t VTotal() const { return VActive + VFrontPorch + VSync + VBackPorch; }
+	constexpr double RefreshRate() const { return HTotal() && VTotal() ? double(PixelClock) / (double(HTotal()) * VTotal()) : 0.0; }
+};
+
+// Same mode as far as the display can tell, drivers round the pixel clock to 10 kHz
+constexpr bool IsSameMode(DisplayTiming const& a, DisplayTiming const& b)
+{
+	uint64_t clockDifference = a.PixelClock > b.PixelClock ? a.PixelClock - b.PixelClock : b.PixelClock - a.PixelClock;
+	return a.HActive == b.HActive && a.VActive == b.VActive && a.HTotal() == b.HTotal() && a.VTotal() == b.VTotal() && clockDifference <= 10000;
+}
+
+enum class TimingStandard : uint32_t
+{
+	Auto, // Cheapest timing the display accepts when its EDID is known, else the driver's choice where there is one, else CVT-RBv2
+	CVT,
+	CVTReducedBlanking,
+	CVTReducedBlankingV2,
+	GTF,
+};
+
+inline constexpr const char* TimingStandardNames[] = { "Auto", "CVT", "CVT-RB", "CVT-RBv2", "GTF" };
+
+std::optional<TimingStandard> ParseTimingStandard(std::string_view name);
+
+// Link between the GPU and the display, bounds the pixel clock
+enum class DisplayLink : uint32_t
+{
+	Unknown,
+	DVI,
+	HDMI14,
+	HDMI20,
+	HDMI21,
+	DisplayPort12,
+	DisplayPort14,
+	DisplayPort20,
+};
+
+inline constexpr const char* DisplayLinkNames[] = { "Unknown", "DVI", "HDMI 1.4", "HDMI 2.0", "HDMI 2.1", "DisplayPort 1.2", "DisplayPort 1.4", "DisplayPort 2.0" };
+
+std::optional<DisplayLink> ParseDisplayLink(std::string_view name);
+
+// Highest pixel clock in Hz the link carries at bitsPerPixel, 0 if unknown
+uint64_t GetMaxPixelClock(DisplayLink link, uint32_t bitsPerPixel);
+
+// VESA CVT with CRT blanking. The pixel clock is a multiple of 0.25 MHz.
+std::optional<DisplayTiming> ComputeCVTTiming(uint32_t width, uint32_t height, double refreshRate);
+
+// VESA CVT reduced blanking (version 1) timing. Keeps the pixel clock, and so the link bandwidth, well below the
+// classic CRT oriented timings. The pixel clock is rounded down to 0.25 MHz as the standard requires, so the resulting
+// refresh rate can be slightly below the requested one.
+std::optional<DisplayTiming> ComputeCVTReducedBlankingTiming(uint32_t width, uint32_t height, double refreshRate);
+
+// VESA CVT reduced blanking version 2: the smallest blanking of the three and a 1 kHz pixel clock step.
+std::optional<DisplayTiming> ComputeCVTReducedBlankingV2Timing(uint32_t width, uint32_t height, double refreshRate);
+
+// VESA GTF with the default parameters, for displays that predate CVT
+std::optional<DisplayTiming> ComputeGTFTiming(uint32_t width, uint32_t height, double refreshRate);
+
+// CVT-RBv2 blanking with a pixel clock chosen to hit broadcast rates (23.976 to 120 Hz, including the 1000/1001
+// family) exactly, for common resolutions. Looked up in a table built at compile time.
+std::optional<DisplayTiming> FindBroadcastTiming(uint32_t width, uint32_t height, double refreshRate);
+
+// Timing of standard for the mode. Auto and CVT-RBv2 prefer the broadcast table.
+std::optional<DisplayTiming> ComputeTiming(TimingStandard standard, uint32_t width, uint32_t height, double refreshRate);
+}
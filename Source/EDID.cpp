@@ -0,0 +1,313 @@
+#include "EDID.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+
+namespace nos::display
+{
+namespace
+{
+constexpr size_t BlockSize = 128;
+constexpr uint8_t Header[] = { 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00 };
+
+constexpr uint8_t CTAExtensionTag = 0x02;
+constexpr uint8_t DisplayIDExtensionTag = 0x70;
+
+constexpr uint32_t HDMIOUI = 0x000C03;
+constexpr uint32_t HDMIForumOUI = 0xC45DD8;
+
+bool IsChecksumValid(std::span<const uint8_t> block)
+{
+	return std::accumulate(block.begin(), block.end(), uint8_t(0)) == 0;
+}
+
+uint16_t Read16(const uint8_t* data)
+{
+	return uint16_t(data[0] | (data[1] << 8));
+}
+
+uint32_t Read24(const uint8_t* data)
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16);
+}
+
+// 18 byte detailed timing descriptor, nothing if it is a display descriptor
+std::optional<DisplayTiming> ParseDetailedTiming(const uint8_t* d)
+{
+	uint16_t pixelClock = Read16(d);
+	if (!pixelClock)
+		return std::nullopt;
+	uint32_t hBlank = d[3] | ((d[4] & 0x0F) << 8);
+	uint32_t vBlank = d[6] | ((d[7] & 0x0F) << 8);
+	DisplayTiming timing;
+	timing.PixelClock = uint64_t(pixelClock) * 10000;
+	timing.HActive = d[2] | ((d[4] & 0xF0) << 4);
+	timing.VActive = d[5] | ((d[7] & 0xF0) << 4);
+	timing.HFrontPorch = d[8] | ((d[11] & 0xC0) << 2);
+	timing.HSync = d[9] | ((d[11] & 0x30) << 4);
+	timing.VFrontPorch = (d[10] >> 4) | ((d[11] & 0x0C) << 2);
+	timing.VSync = (d[10] & 0x0F) | ((d[11] & 0x03) << 4);
+	if (timing.HFrontPorch + timing.HSync > hBlank || timing.VFrontPorch + timing.VSync > vBlank)
+		return std::nullopt;
+	timing.HBackPorch = hBlank - timing.HFrontPorch - timing.HSync;
+	timing.VBackPorch = vBlank - timing.VFrontPorch - timing.VSync;
+	// Interlaced modes are not driven by the plugin
+	if (d[17] & 0x80)
+		return std::nullopt;
+	bool digitalSeparate = (d[17] & 0x18) == 0x18;
+	timing.HSyncPositive = digitalSeparate && (d[17] & 0x02);
+	timing.VSyncPositive = digitalSeparate && (d[17] & 0x04);
+	return timing;
+}
+
+std::string ParseDescriptorString(const uint8_t* d)
+{
+	std::string result(reinterpret_cast<const char*>(d + 5), 13);
+	result.erase(std::find(result.begin(), result.end(), '\n'), result.end());
+	while (!result.empty() && result.back() == ' ')
+		result.pop_back();
+	return result;
+}
+
+void ParseDescriptor(const uint8_t* d, DisplayCapabilities& caps)
+{
+	if (auto timing = ParseDetailedTiming(d))
+	{
+		caps.DetailedTimings.push_back(*timing);
+		return;
+	}
+	if (d[0] || d[1])
+		return;
+	switch (d[3])
+	{
+	case 0xFC: caps.MonitorName = ParseDescriptorString(d); break;
+	case 0xFD: {
+		DisplayRangeLimits limits;
+		// Rate offsets of EDID 1.4 extend the ranges past 255
+		limits.MinVerticalRate = d[5] + ((d[4] & 0x03) == 0x03 ? 255 : 0);
+		limits.MaxVerticalRate = d[6] + ((d[4] & 0x02) ? 255 : 0);
+		limits.MinHorizontalRate = d[7] + ((d[4] & 0x0C) == 0x0C ? 255 : 0);
+		limits.MaxHorizontalRate = d[8] + ((d[4] & 0x08) ? 255 : 0);
+		limits.MaxPixelClock = uint64_t(d[9]) * 10000000;
+		caps.RangeLimits = limits;
+		break;
+	}
+	default: break;
+	}
+}
+
+void ParseHDMIForumBlock(const uint8_t* block, size_t length, DisplayCapabilities& caps)
+{
+	// Lanes and per lane rate of each Max_FRL_Rate code
+	constexpr uint64_t FRLRates[] = { 0, 3 * 3000000000ull, 3 * 6000000000ull, 4 * 6000000000ull, 4 * 8000000000ull, 4 * 10000000000ull, 4 * 12000000000ull };
+	if (length >= 5 && block[5])
+		caps.MaxTMDSClock = std::max(caps.MaxTMDSClock, uint64_t(block[5]) * 5000000);
+	if (length >= 7)
+		if (uint32_t frl = block[7] >> 4; frl < std::size(FRLRates))
+			caps.MaxFRLBitRate = FRLRates[frl];
+	if (length >= 10)
+	{
+		VariableRefreshRange vrr{ .Min = uint32_t(block[9] & 0x3F), .Max = uint32_t(((block[9] & 0xC0) << 2) | block[10]) };
+		if (vrr.Min && vrr.Max > vrr.Min)
+			caps.VRR = vrr;
+	}
+}
+
+void ParseHDRStaticMetadataBlock(const uint8_t* payload, size_t length, DisplayCapabilities& caps)
+{
+	// payload[0] is the extended tag
+	if (length < 3)
+		return;
+	HDRStaticMetadata hdr;
+	hdr.TraditionalSDR = payload[1] & 0x01;
+	hdr.TraditionalHDR = payload[1] & 0x02;
+	hdr.PQ = payload[1] & 0x04;
+	hdr.HLG = payload[1] & 0x08;
+	if (length >= 4 && payload[3])
+		hdr.MaxLuminance = 50.0f * std::pow(2.0f, payload[3] / 32.0f);
+	if (length >= 5 && payload[4])
+		hdr.MaxFrameAverageLuminance = 50.0f * std::pow(2.0f, payload[4] / 32.0f);
+	if (length >= 6 && hdr.MaxLuminance > 0)
+		hdr.MinLuminance = hdr.MaxLuminance * (payload[5] / 255.0f) * (payload[5] / 255.0f) / 100.0f;
+	caps.HDR = hdr;
+}
+
+void ParseCTAExtension(std::span<const uint8_t> block, DisplayCapabilities& caps)
+{
+	size_t timingsOffset = block[2];
+	if (timingsOffset < 4 || timingsOffset > BlockSize - 1)
+		timingsOffset = BlockSize - 1;
+	for (size_t offset = 4; offset < timingsOffset;)
+	{
+		uint8_t tag = block[offset] >> 5;
+		size_t length = block[offset] & 0x1F;
+		if (offset + 1 + length > timingsOffset)
+			break;
+		const uint8_t* data = &block[offset];
+		if (tag == 3 && length >= 3)
+		{
+			uint32_t oui = Read24(data + 1);
+			if (oui == HDMIOUI && length >= 7 && data[7])
+				caps.MaxTMDSClock = std::max(caps.MaxTMDSClock, uint64_t(data[7]) * 5000000);
+			else if (oui == HDMIForumOUI)
+				ParseHDMIForumBlock(data, length, caps);
+		}
+		else if (tag == 7 && length >= 1)
+		{
+			if (data[1] == 6)
+				ParseHDRStaticMetadataBlock(data + 1, length, caps);
+			else if (data[1] == 0x79) // HDMI Forum sink capability data block, same layout as the vendor block
+				ParseHDMIForumBlock(data, length, caps);
+		}
+		offset += 1 + length;
+	}
+	for (size_t offset = timingsOffset; offset + 18 <= BlockSize - 1; offset += 18)
+		if (auto timing = ParseDetailedTiming(&block[offset]))
+			caps.DetailedTimings.push_back(*timing);
+}
+
+// DisplayID type I (10 kHz clock) and type VII (1 kHz clock) detailed timings, 20 bytes each
+void ParseDisplayIDTimings(const uint8_t* payload, size_t length, uint64_t clockUnit, DisplayCapabilities& caps)
+{
+	for (size_t offset = 0; offset + 20 <= length; offset += 20)
+	{
+		const uint8_t* d = payload + offset;
+		if (d[3] & 0x10) // Interlaced
+			continue;
+		DisplayTiming timing;
+		timing.PixelClock = (uint64_t(Read24(d)) + 1) * clockUnit;
+		timing.HActive = Read16(d + 4) + 1u;
+		uint32_t hBlank = Read16(d + 6) + 1u;
+		timing.HFrontPorch = (Read16(d + 8) & 0x7FFF) + 1u;
+		timing.HSyncPositive = d[9] & 0x80;
+		timing.HSync = Read16(d + 10) + 1u;
+		timing.VActive = Read16(d + 12) + 1u;
+		uint32_t vBlank = Read16(d + 14) + 1u;
+		timing.VFrontPorch = (Read16(d + 16) & 0x7FFF) + 1u;
+		timing.VSyncPositive = d[17] & 0x80;
+		timing.VSync = Read16(d + 18) + 1u;
+		if (timing.HFrontPorch + timing.HSync > hBlank || timing.VFrontPorch + timing.VSync > vBlank)
+			continue;
+		timing.HBackPorch = hBlank - timing.HFrontPorch - timing.HSync;
+		timing.VBackPorch = vBlank - timing.VFrontPorch - timing.VSync;
+		// Preferred timings go first
+		if (d[3] & 0x80)
+			caps.DetailedTimings.insert(caps.DetailedTimings.begin(), timing);
+		else
+			caps.DetailedTimings.push_back(timing);
+	}
+}
+
+void ParseDisplayIDExtension(std::span<const uint8_t> block, DisplayCapabilities& caps)
+{
+	size_t sectionEnd = std::min<size_t>(5 + block[2], BlockSize - 1);
+	for (size_t offset = 5; offset + 3 <= sectionEnd;)
+	{
+		uint8_t tag = block[offset];
+		size_t length = block[offset + 2];
+		if (offset + 3 + length > sectionEnd)
+			break;
+		if (tag == 0x03)
+			ParseDisplayIDTimings(&block[offset + 3], length, 10000, caps);
+		else if (tag == 0x22)
+			ParseDisplayIDTimings(&block[offset + 3], length, 1000, caps);
+		offset += 3 + length;
+	}
+}
+}
+
+std::optional<DisplayCapabilities> ParseEDID(std::span<const uint8_t> edid)
+{
+	if (edid.size() < BlockSize || !std::equal(std::begin(Header), std::end(Header), edid.begin()) || !IsChecksumValid(edid.first(BlockSize)))
+		return std::nullopt;
+	DisplayCapabilities caps;
+	uint16_t manufacturer = uint16_t((edid[8] << 8) | edid[9]);
+	for (int shift : { 10, 5, 0 })
+		caps.ManufacturerId.push_back(char('A' - 1 + ((manufacturer >> shift) & 0x1F)));
+	caps.ProductCode = Read16(&edid[10]);
+	caps.SerialNumber = edid[12] | (edid[13] << 8) | (edid[14] << 16) | (uint32_t(edid[15]) << 24);
+	bool digital = edid[20] & 0x80;
+	bool revision4 = edid[18] == 1 && edid[19] >= 4;
+	if (digital && revision4)
+		caps.Interface = EDIDInterface(edid[20] & 0x0F);
+	caps.ContinuousFrequency = revision4 && (edid[24] & 0x01);
+	for (size_t offset = 54; offset < 126; offset += 18)
+		ParseDescriptor(&edid[offset], caps);
+
+	size_t extensionCount = std::min<size_t>(edid[126], edid.size() / BlockSize - 1);
+	for (size_t i = 1; i <= extensionCount; ++i)
+	{
+		auto block = edid.subspan(i * BlockSize, BlockSize);
+		if (!IsChecksumValid(block))
+			continue;
+		if (block[0] == CTAExtensionTag)
+			ParseCTAExtension(block, caps);
+		else if (block[0] == DisplayIDExtensionTag)
+			ParseDisplayIDExtension(block, caps);
+	}
+	// Adaptive sync over DisplayPort is announced as continuous frequency within the range limits
+	if (!caps.VRR && caps.ContinuousFrequency && caps.RangeLimits && caps.RangeLimits->MaxVerticalRate > caps.RangeLimits->MinVerticalRate)
+		caps.VRR = VariableRefreshRange{ .Min = caps.RangeLimits->MinVerticalRate, .Max = caps.RangeLimits->MaxVerticalRate };
+	return caps;
+}
+
+std::optional<DisplayTiming> DisplayCapabilities::GetNativeTiming() const
+{
+	if (DetailedTimings.empty())
+		return std::nullopt;
+	return DetailedTimings.front();
+}
+
+uint64_t DisplayCapabilities::GetMaxPixelClock(uint32_t bitsPerPixel) const
+{
+	uint64_t result = 0;
+	auto limit = [&](uint64_t pixelClock) {
+		if (pixelClock)
+			result = result ? std::min(result, pixelClock) : pixelClock;
+	};
+	if (bitsPerPixel)
+	{
+		// FRL carries 16 bits per 18, TMDS 8 bits per channel character with three channels
+		uint64_t linkBitRate = std::max(MaxFRLBitRate * 16 / 18, MaxTMDSClock * 24);
+		limit(linkBitRate / bitsPerPixel);
+	}
+	if (RangeLimits)
+		limit(RangeLimits->MaxPixelClock);
+	return result;
+}
+
+std::optional<std::string> DisplayCapabilities::Reject(DisplayTiming const& timing, uint32_t bitsPerPixel) const
+{
+	char reason[160];
+	// Advertised timings are accepted as is
+	for (auto& detailed : DetailedTimings)
+		if (detailed.HActive == timing.HActive && detailed.VActive == timing.VActive && detailed.HTotal() == timing.HTotal() &&
+			detailed.VTotal() == timing.VTotal() && detailed.PixelClock == timing.PixelClock)
+			return std::nullopt;
+	if (uint64_t maxPixelClock = GetMaxPixelClock(bitsPerPixel); maxPixelClock && timing.PixelClock > maxPixelClock)
+	{
+		std::snprintf(reason, sizeof(reason), "pixel clock of %.2f MHz is above the display's %.2f MHz", timing.PixelClock / 1e6, maxPixelClock / 1e6);
+		return reason;
+	}
+	if (!RangeLimits)
+		return std::nullopt;
+	double refreshRate = timing.RefreshRate();
+	// Range limits are whole numbers, a 0.5 Hz margin keeps 59.94 within a 60 Hz limit
+	if (refreshRate < RangeLimits->MinVerticalRate - 0.5 || refreshRate > RangeLimits->MaxVerticalRate + 0.5)
+	{
+		std::snprintf(reason, sizeof(reason), "refresh rate of %.3f Hz is outside the display's %u-%u Hz", refreshRate, RangeLimits->MinVerticalRate,
+					  RangeLimits->MaxVerticalRate);
+		return reason;
+	}
+	double horizontalRate = timing.HTotal() ? double(timing.PixelClock) / timing.HTotal() / 1000.0 : 0.0;
+	if (horizontalRate < RangeLimits->MinHorizontalRate - 0.5 || horizontalRate > RangeLimits->MaxHorizontalRate + 0.5)
+	{
+		std::snprintf(reason, sizeof(reason), "line rate of %.2f kHz is outside the display's %u-%u kHz", horizontalRate, RangeLimits->MinHorizontalRate,
+					  RangeLimits->MaxHorizontalRate);
+		return reason;
+	}
+	return std::nullopt;
+}
+}
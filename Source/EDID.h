@@ -0,0 +1,75 @@
+#pragma once
+
+#include "DisplayTiming.h"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace nos::display
+{
+// Monitor range limits display descriptor
+struct DisplayRangeLimits
+{
+	uint32_t MinVerticalRate = 0, MaxVerticalRate = 0; // In Hz
+	uint32_t MinHorizontalRate = 0, MaxHorizontalRate = 0; // In kHz
+	uint64_t MaxPixelClock = 0; // In Hz, 0 if not given
+};
+
+struct VariableRefreshRange
+{
+	uint32_t Min = 0, Max = 0; // In Hz
+};
+
+// CTA-861 HDR static metadata data block
+struct HDRStaticMetadata
+{
+	bool TraditionalSDR = false;
+	bool TraditionalHDR = false;
+	bool PQ = false; // SMPTE ST 2084
+	bool HLG = false;
+	float MaxLuminance = 0; // Desired content luminances in cd/m2, 0 if not given
+	float MaxFrameAverageLuminance = 0;
+	float MinLuminance = 0;
+};
+
+enum class EDIDInterface : uint8_t
+{
+	Undefined = 0,
+	DVI = 1,
+	HDMIa = 2,
+	HDMIb = 3,
+	MDDI = 4,
+	DisplayPort = 5,
+};
+
+// What an EDID (with its CTA-861 and DisplayID extensions) says the display can do
+struct DisplayCapabilities
+{
+	std::string ManufacturerId; // Three letter PNP id
+	uint16_t ProductCode = 0;
+	uint32_t SerialNumber = 0;
+	std::string MonitorName;
+	EDIDInterface Interface = EDIDInterface::Undefined;
+	bool ContinuousFrequency = false; // Any timing within the range limits is accepted
+	std::vector<DisplayTiming> DetailedTimings; // Preferred timing first
+	std::optional<DisplayRangeLimits> RangeLimits;
+	std::optional<VariableRefreshRange> VRR;
+	std::optional<HDRStaticMetadata> HDR;
+	uint64_t MaxTMDSClock = 0; // In Hz, from the HDMI vendor blocks. 0 if not given.
+	uint64_t MaxFRLBitRate = 0; // In bits per second over all lanes, 0 if FRL is not supported
+
+	// Preferred detailed timing, the panel's native mode on fixed pixel displays
+	std::optional<DisplayTiming> GetNativeTiming() const;
+	// Highest pixel clock the display accepts at bitsPerPixel over its HDMI link and range limits, 0 if unknown
+	uint64_t GetMaxPixelClock(uint32_t bitsPerPixel) const;
+	// Why the display cannot show timing, nothing if it can or if the EDID does not tell
+	std::optional<std::string> Reject(DisplayTiming const& timing, uint32_t bitsPerPixel) const;
+};
+
+// Parses a raw EDID blob: the 128 byte base block and any extension blocks after it. Blocks with a bad checksum
+// are skipped, nothing is returned if the base block is invalid.
+std::optional<DisplayCapabilities> ParseEDID(std::span<const uint8_t> edid);
+}
@@ -0,0 +1,151 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#if defined(WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#endif
+
+namespace nos::display
+{
+PacingClock::TimePoint SteadyPacingClock::Now()
+{
+	return std::chrono::time_point_cast<Duration>(std::chrono::steady_clock::now());
+}
+
+void SteadyPacingClock::SleepFor(Duration duration)
+{
+	if (duration <= Duration::zero())
+		return;
+#if defined(WIN32)
+	// Sleep() is bound to the system timer resolution (15.6ms by default), use a high resolution waitable timer instead.
+	thread_local HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (timer)
+	{
+		LARGE_INTEGER dueTime{};
+		dueTime.QuadPart = -std::max<LONGLONG>(1, duration.count() / 100); // Relative, in 100ns units
+		if (SetWaitableTimerEx(timer, &dueTime, 0, nullptr, nullptr, nullptr, 0))
+		{
+			WaitForSingleObject(timer, INFINITE);
+			return;
+		}
+	}
+#endif
+	std::this_thread::sleep_for(duration);
+}
+
+void SteadyPacingClock::Spin()
+{
+	std::this_thread::yield();
+}
+
+SteadyPacingClock& SteadyPacingClock::Get()
+{
+	static SteadyPacingClock clock;
+	return clock;
+}
+
+void FramePacer::SetTargetRate(float framesPerSecond)
+{
+	Duration period{};
+	if (framesPerSecond > 0.0f)
+		period = std::chrono::duration_cast<Duration>(std::chrono::duration<double>(1.0 / framesPerSecond));
+	if (period == Period)
+		return;
+	Period = period;
+	Reset();
+}
+
+void FramePacer::Reset()
+{
+	NextDeadline = std::nullopt;
+	LastReleased = std::nullopt;
+	IntervalCount = 0;
+	IntervalHead = 0;
+	LateFrames = 0;
+}
+
+FramePacer::TimePoint FramePacer::WaitForNextFrame()
+{
+	if (Period <= Duration::zero())
+		return MarkFrame();
+	auto now = Clock->Now();
+	// Start a new deadline chain on the first frame or after falling behind by more than a frame, instead of bursting to catch up.
+	if (!NextDeadline || now - *NextDeadline > Period)
+	{
+		if (NextDeadline)
+			++LateFrames;
+		NextDeadline = now;
+	}
+	auto deadline = *NextDeadline;
+	if (deadline - now > SpinMargin)
+		Clock->SleepFor(deadline - now - SpinMargin);
+	while ((now = Clock->Now()) < deadline)
+		Clock->Spin();
+	NextDeadline = deadline + Period;
+	Record(now);
+	return now;
+}
+
+std::optional<FramePacer::TimePoint> FramePacer::TryReleaseFrame()
+{
+	if (Period <= Duration::zero())
+		return MarkFrame();
+	auto now = Clock->Now();
+	if (NextDeadline && now < *NextDeadline)
+		return std::nullopt;
+	if (!NextDeadline || now - *NextDeadline > Period)
+	{
+		if (NextDeadline)
+			++LateFrames;
+		NextDeadline = now;
+	}
+	NextDeadline = *NextDeadline + Period;
+	Record(now);
+	return now;
+}
+
+FramePacer::TimePoint FramePacer::MarkFrame()
+{
+	auto now = Clock->Now();
+	Record(now);
+	return now;
+}
+
+void FramePacer::Record(TimePoint released)
+{
+	if (LastReleased)
+	{
+		Intervals[IntervalHead] = std::chrono::duration<double>(released - *LastReleased).count();
+		IntervalHead = (IntervalHead + 1) % HistorySize;
+		IntervalCount = std::min(IntervalCount + 1, HistorySize);
+	}
+	LastReleased = released;
+}
+
+FramePacer::Duration FramePacer::GetAchievedInterval() const
+{
+	if (!IntervalCount)
+		return {};
+	double sum = 0;
+	for (size_t i = 0; i < IntervalCount; ++i)
+		sum += Intervals[i];
+	return std::chrono::duration_cast<Duration>(std::chrono::duration<double>(sum / IntervalCount));
+}
+
+FramePacer::Duration FramePacer::GetJitter() const
+{
+	if (!IntervalCount)
+		return {};
+	double reference = Period > Duration::zero() ? std::chrono::duration<double>(Period).count()
+												 : std::chrono::duration<double>(GetAchievedInterval()).count();
+	double sumSq = 0;
+	for (size_t i = 0; i < IntervalCount; ++i)
+		sumSq += (Intervals[i] - reference) * (Intervals[i] - reference);
+	return std::chrono::duration_cast<Duration>(std::chrono::duration<double>(std::sqrt(sumSq / IntervalCount)));
+}
+}
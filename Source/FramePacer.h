@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <optional>
+
+namespace nos::display
+{
+struct PacingClock
+{
+	using Duration = std::chrono::nanoseconds;
+	using TimePoint = std::chrono::time_point<std::chrono::steady_clock, Duration>;
+
+	virtual ~PacingClock() = default;
+	virtual TimePoint Now() = 0;
+	virtual void SleepFor(Duration duration) = 0;
+	virtual void Spin() {}
+};
+
+struct SteadyPacingClock : PacingClock
+{
+	TimePoint Now() override;
+	void SleepFor(Duration duration) override;
+	void Spin() override;
+
+	static SteadyPacingClock& Get();
+};
+
+// Paces a self-scheduling node to a target rate against deadlines of a PacingClock.
+// Coarse waiting is done with SleepFor, the last SpinMargin before the deadline is spun.
+struct FramePacer
+{
+	using Duration = PacingClock::Duration;
+	using TimePoint = PacingClock::TimePoint;
+
+	explicit FramePacer(PacingClock& clock) : Clock(&clock) {}
+
+	void SetTargetRate(float framesPerSecond);
+	void SetSpinMargin(Duration margin) { SpinMargin = margin; }
+	void Reset();
+
+	// Blocks until the next frame deadline. Returns the time the frame was released at.
+	TimePoint WaitForNextFrame();
+	// Releases the next frame if its deadline has passed, returns nullopt instead of waiting otherwise.
+	std::optional<TimePoint> TryReleaseFrame();
+	// Records a frame start without waiting, keeps the statistics meaningful when pacing is off.
+	TimePoint MarkFrame();
+
+	Duration GetTargetInterval() const { return Period; }
+	// Deadline of the frame after the last released one, not set before the first frame or without a target rate
+	std::optional<TimePoint> GetNextDeadline() const { return NextDeadline; }
+	// Mean interval between the last released frames
+	Duration GetAchievedInterval() const;
+	// Root mean square deviation of the last intervals from the target (or from the mean if there is no target)
+	Duration GetJitter() const;
+	uint64_t GetLateFrameCount() const { return LateFrames; }
+
+protected:
+	void Record(TimePoint released);
+
+	static constexpr size_t HistorySize = 128;
+
+	PacingClock* Clock;
+	Duration Period{};
+	Duration SpinMargin = std::chrono::microseconds(1500);
+	std::optional<TimePoint> NextDeadline;
+	std::optional<TimePoint> LastReleased;
+	std::array<double, HistorySize> Intervals{};
+	size_t IntervalCount = 0;
+	size_t IntervalHead = 0;
+	uint64_t LateFrames = 0;
+};
+}
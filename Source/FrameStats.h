@@ -0,0 +1,105 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+
+namespace nos::display
+{
+struct LatencySummary
+{
+	float P50 = 0;
+	float P95 = 0;
+	float P99 = 0;
+	float Max = 0;
+};
+
+// Fixed size window of the latest samples, in milliseconds. Summarize() does not allocate.
+template <size_t WindowSize = 256>
+struct RollingLatency
+{
+	void Add(std::chrono::nanoseconds sample)
+	{
+		Samples[Head] = std::chrono::duration<float, std::milli>(sample).count();
+		Head = (Head + 1) % WindowSize;
+		Count = std::min(Count + 1, WindowSize);
+	}
+
+	void Clear()
+	{
+		Head = 0;
+		Count = 0;
+	}
+
+	size_t GetCount() const { return Count; }
+
+	LatencySummary Summarize()
+	{
+		if (!Count)
+			return {};
+		std::copy_n(Samples.begin(), Count, Scratch.begin());
+		auto begin = Scratch.begin(), end = Scratch.begin() + Count;
+		auto percentile = [&](float p) {
+			auto nth = begin + std::min(Count - 1, size_t(p * Count));
+			std::nth_element(begin, nth, end);
+			return *nth;
+		};
+		LatencySummary summary;
+		summary.P50 = percentile(0.50f);
+		summary.P95 = percentile(0.95f);
+		summary.P99 = percentile(0.99f);
+		summary.Max = *std::max_element(begin, end);
+		return summary;
+	}
+
+private:
+	std::array<float, WindowSize> Samples{};
+	std::array<float, WindowSize> Scratch{};
+	size_t Head = 0;
+	size_t Count = 0;
+};
+
+enum class PresentStage : uint32_t
+{
+	FrameWait,	// Waiting for a frame slot (MaxFramesInFlight)
+	Acquire,	// SwapchainAcquireNextImage
+	Record,		// Begin + Copy + ImageStateToPresent
+	Submit,		// End
+	Present,	// SwapchainPresent
+	Completion, // Submit until the frame's GPU event is seen signalled, which is only checked once per frame
+	Frame,		// Whole ExecuteNode
+	SwapchainRecreate,
+	MonitorEnumeration,
+	Count
+};
+
+inline const char* GetPresentStageName(PresentStage stage)
+{
+	switch (stage)
+	{
+	case PresentStage::FrameWait: return "FrameWait";
+	case PresentStage::Acquire: return "Acquire";
+	case PresentStage::Record: return "Record";
+	case PresentStage::Submit: return "Submit";
+	case PresentStage::Present: return "Present";
+	case PresentStage::Completion: return "SubmitToCompletion";
+	case PresentStage::Frame: return "Frame";
+	case PresentStage::SwapchainRecreate: return "Recreate";
+	case PresentStage::MonitorEnumeration: return "MonitorEnumeration";
+	default: return "Unknown";
+	}
+}
+
+struct PresentStageStats
+{
+	void Add(PresentStage stage, std::chrono::nanoseconds sample) { Stages[size_t(stage)].Add(sample); }
+	LatencySummary Summarize(PresentStage stage) { return Stages[size_t(stage)].Summarize(); }
+	void Clear()
+	{
+		for (auto& stage : Stages)
+			stage.Clear();
+	}
+
+	std::array<RollingLatency<>, size_t(PresentStage::Count)> Stages;
+};
+}
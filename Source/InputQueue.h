@@ -0,0 +1,128 @@
+#pragma once
+
+#include <Nodos/PluginHelpers.hpp>
+#include <nosVulkanSubsystem/nosVulkanSubsystem.h>
+
+#include <array>
+#include <optional>
+#include <string_view>
+
+namespace nos::display
+{
+enum class InputPolicy : uint32_t
+{
+	Latest,		// Present the newest input, drop the ones that were not presented in time. Nothing is presented without a new input.
+	FIFO,		// Present every input in order
+	RepeatLast, // Present the newest input, present the last one again when there is no new input
+};
+
+inline constexpr const char* InputPolicyNames[] = { "Latest", "FIFO", "RepeatLast" };
+
+inline std::optional<InputPolicy> ParseInputPolicy(std::string_view name)
+{
+	for (uint32_t i = 0; i < std::size(InputPolicyNames); ++i)
+		if (name == InputPolicyNames[i])
+			return InputPolicy(i);
+	return std::nullopt;
+}
+
+// Small ring of input texture references waiting to be presented. Inputs are told apart by the upstream frame they were
+// received with, not by texture: an upstream that keeps rewriting one texture hands over a new input with every frame.
+// A queued input whose texture is received again was overwritten by upstream and is dropped, it is never presented with
+// the contents of a later frame.
+struct InputQueue
+{
+	static constexpr size_t Capacity = 4;
+
+	// frame identifies the upstream frame the input belongs to, an input of a frame that was already received is ignored
+	void Receive(nosResourceShareInfo const& texture, uint64_t frame)
+	{
+		if (LastFrame && *LastFrame == frame)
+			return;
+		LastFrame = frame;
+		DropQueued(texture.Memory.Handle);
+		if (Count == Capacity)
+			Pop(), ++Dropped;
+		Frames[(Head + Count++) % Capacity] = { texture };
+	}
+
+	// The input to present next, if any. repeatLast presents the last input again when nothing new was received.
+	std::optional<nosResourceShareInfo> Next(InputPolicy policy, bool repeatLast)
+	{
+		if (!Count)
+		{
+			if (!Last || (policy != InputPolicy::RepeatLast && !repeatLast))
+				return std::nullopt;
+			++Repeated;
+			return Last;
+		}
+		if (policy != InputPolicy::FIFO)
+		{
+			Dropped += Count - 1;
+			Head = (Head + Count - 1) % Capacity;
+			Count = 1;
+		}
+		Last = Pop();
+		return Last;
+	}
+
+	// Returns an input taken by Next, to be presented by the next frame instead
+	void PutBack(nosResourceShareInfo const& texture)
+	{
+		if (Count == Capacity)
+		{
+			++Dropped;
+			return;
+		}
+		Head = (Head + Capacity - 1) % Capacity;
+		Frames[Head] = { texture, true };
+		++Count;
+	}
+
+	void Clear()
+	{
+		Head = Count = 0;
+		Last = std::nullopt;
+		LastFrame = std::nullopt;
+	}
+
+	uint64_t Dropped = 0;
+	uint64_t Repeated = 0;
+
+private:
+	struct QueuedInput
+	{
+		nosResourceShareInfo Texture{};
+		bool PutBack = false; // Taken by a frame that could not present it, it goes out as it is
+	};
+
+	// Inputs that were put back are kept: the frame that took them already committed to presenting their texture
+	void DropQueued(uint64_t handle)
+	{
+		size_t kept = 0;
+		for (size_t i = 0; i < Count; ++i)
+		{
+			auto& frame = Frames[(Head + i) % Capacity];
+			if (!frame.PutBack && frame.Texture.Memory.Handle == handle)
+				++Dropped;
+			else
+				Frames[(Head + kept++) % Capacity] = frame;
+		}
+		Count = kept;
+	}
+
+	nosResourceShareInfo Pop()
+	{
+		auto frame = Frames[Head].Texture;
+		Head = (Head + 1) % Capacity;
+		--Count;
+		return frame;
+	}
+
+	std::array<QueuedInput, Capacity> Frames{};
+	size_t Head = 0;
+	size_t Count = 0;
+	std::optional<nosResourceShareInfo> Last;
+	std::optional<uint64_t> LastFrame;
+};
+}
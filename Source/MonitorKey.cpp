@@ -0,0 +1,74 @@
+#include "MonitorKey.h"
+
+#include <algorithm>
+#include <charconv>
+
+namespace nos::display
+{
+static constexpr std::string_view GPUPrefix = " [GPU ";
+static constexpr std::string_view PortSeparator = " / Port ";
+static constexpr std::string_view Suffix = "]";
+static constexpr std::string_view LegacySeparator = " - ";
+
+size_t FormatMonitorLabel(std::string_view monitorName, MonitorKey key, std::span<char> out)
+{
+	if (out.empty())
+		return 0;
+	// Render the suffix first so that the name is truncated instead of the key
+	std::array<char, 64> suffix;
+	auto cursor = std::copy(GPUPrefix.begin(), GPUPrefix.end(), suffix.begin());
+	cursor = std::to_chars(cursor, suffix.data() + suffix.size(), key.GPUBusId).ptr;
+	cursor = std::copy(PortSeparator.begin(), PortSeparator.end(), cursor);
+	cursor = std::to_chars(cursor, suffix.data() + suffix.size(), key.PortId).ptr;
+	cursor = std::copy(Suffix.begin(), Suffix.end(), cursor);
+	size_t suffixLength = std::min<size_t>(cursor - suffix.data(), out.size() - 1);
+	size_t nameLength = std::min(monitorName.size(), out.size() - 1 - suffixLength);
+	auto end = std::copy_n(monitorName.begin(), nameLength, out.begin());
+	end = std::copy_n(suffix.begin(), suffixLength, end);
+	*end = '\0';
+	return nameLength + suffixLength;
+}
+
+template <typename T>
+static bool ParseNumber(std::string_view str, T& out)
+{
+	if (str.empty())
+		return false;
+	auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), out);
+	return ec == std::errc() && ptr == str.data() + str.size();
+}
+
+static std::optional<MonitorKey> ParseLegacyMonitorLabel(std::string_view label)
+{
+	size_t portStart = label.rfind(LegacySeparator);
+	if (portStart == std::string_view::npos)
+		return std::nullopt;
+	size_t gpuStart = label.rfind(LegacySeparator, portStart == 0 ? 0 : portStart - 1);
+	if (gpuStart == std::string_view::npos || gpuStart == portStart)
+		return std::nullopt;
+	uint64_t gpuHandle;
+	MonitorKey key;
+	if (!ParseNumber(label.substr(gpuStart + LegacySeparator.size(), portStart - gpuStart - LegacySeparator.size()), gpuHandle) ||
+		!ParseNumber(label.substr(portStart + LegacySeparator.size()), key.PortId))
+		return std::nullopt;
+	return key;
+}
+
+std::optional<MonitorKey> ParseMonitorLabel(std::string_view label)
+{
+	if (!label.ends_with(Suffix))
+		return ParseLegacyMonitorLabel(label);
+	size_t gpuStart = label.rfind(GPUPrefix);
+	if (gpuStart == std::string_view::npos)
+		return std::nullopt;
+	auto key = label.substr(gpuStart + GPUPrefix.size(), label.size() - Suffix.size() - gpuStart - GPUPrefix.size());
+	size_t separator = key.find(PortSeparator);
+	if (separator == std::string_view::npos)
+		return std::nullopt;
+	MonitorKey result;
+	if (!ParseNumber(key.substr(0, separator), result.GPUBusId) ||
+		!ParseNumber(key.substr(separator + PortSeparator.size()), result.PortId))
+		return std::nullopt;
+	return result;
+}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <compare>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace nos::display
+{
+// Identifies a display by the PCI bus of its GPU and the GPU output. Unlike GPU handles these are stable across reboots.
+struct MonitorKey
+{
+	static constexpr uint32_t AnyGPU = UINT32_MAX;
+
+	uint32_t GPUBusId = AnyGPU;
+	uint32_t PortId = 0;
+	auto operator<=>(const MonitorKey&) const = default;
+};
+
+struct MonitorKeyHash
+{
+	size_t operator()(MonitorKey const& key) const
+	{
+		return std::hash<uint64_t>()((uint64_t(key.GPUBusId) << 32) | key.PortId);
+	}
+};
+
+// Null terminated "<monitor name> [GPU <bus id> / Port <port id>]", long monitor names are truncated.
+using MonitorLabel = std::array<char, 128>;
+
+// Writes the label of a monitor into out without allocating. Returns the length, excluding the null terminator.
+size_t FormatMonitorLabel(std::string_view monitorName, MonitorKey key, std::span<char> out);
+
+// Parses the key back from a label. Only the suffix is parsed, so the monitor name can contain anything.
+// Labels of older versions ("<monitor name> - <GPU handle> - <port id>") yield a key with AnyGPU, as GPU handles do not survive reboots.
+std::optional<MonitorKey> ParseMonitorLabel(std::string_view label);
+}
@@ -1,7 +1,12 @@
+#if defined(WIN32)
 #include "CustomResolutionBase.h"
 
 #include <nvapi/nvapi.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
 
 namespace nos::display
 {
@@ -12,6 +17,46 @@ std::string GetErrorString(NvAPI_Status status)
 	return errorString;
 }
 
+// NvAPI counts the pixel clock in 10 kHz, the exact refresh rate goes along in rrx1k
+NV_TIMING ToNVTiming(DisplayTiming const& timing, const char* standardName)
+{
+	NV_TIMING result{};
+	result.HVisible = NvU16(timing.HActive);
+	result.HFrontPorch = NvU16(timing.HFrontPorch);
+	result.HSyncWidth = NvU16(timing.HSync);
+	result.HTotal = NvU16(timing.HTotal());
+	result.HSyncPol = timing.HSyncPositive ? NV_HSYNC_POLARITY_PH : NV_HSYNC_POLARITY_NH;
+	result.VVisible = NvU16(timing.VActive);
+	result.VFrontPorch = NvU16(timing.VFrontPorch);
+	result.VSyncWidth = NvU16(timing.VSync);
+	result.VTotal = NvU16(timing.VTotal());
+	result.VSyncPol = timing.VSyncPositive ? NV_VSYNC_POLARITY_PV : NV_VSYNC_POLARITY_NV;
+	result.pclk = NvU32((timing.PixelClock + 5000) / 10000);
+	result.etc.rr = NvU16(std::lround(timing.RefreshRate()));
+	result.etc.rrx1k = NvU32(std::llround(timing.RefreshRate() * 1000.0));
+	result.etc.rep = 1;
+	result.etc.status = NV_TIMING_OVERRIDE_CUST;
+	std::snprintf((char*)result.etc.name, sizeof(result.etc.name), "%s:%ux%u@%.3f", standardName, timing.HActive, timing.VActive, timing.RefreshRate());
+	return result;
+}
+
+DisplayTiming FromNVTiming(NV_TIMING const& timing)
+{
+	DisplayTiming result;
+	result.HActive = timing.HVisible;
+	result.HFrontPorch = timing.HFrontPorch;
+	result.HSync = timing.HSyncWidth;
+	result.HBackPorch = timing.HTotal - timing.HVisible - timing.HFrontPorch - timing.HSyncWidth;
+	result.VActive = timing.VVisible;
+	result.VFrontPorch = timing.VFrontPorch;
+	result.VSync = timing.VSyncWidth;
+	result.VBackPorch = timing.VTotal - timing.VVisible - timing.VFrontPorch - timing.VSyncWidth;
+	result.PixelClock = uint64_t(timing.pclk) * 10000;
+	result.HSyncPositive = timing.HSyncPol == NV_HSYNC_POLARITY_PH;
+	result.VSyncPositive = timing.VSyncPol == NV_VSYNC_POLARITY_PV;
+	return result;
+}
+
 struct NVIDIACustomResolution : CustomResolutionBase
 {
 	bool Init() override
@@ -31,6 +76,9 @@ struct NVIDIACustomResolution : CustomResolutionBase
 
 	std::optional<NvU32> GetDisplayIdFromPort(GPUPortIdentifier portId)
 	{
+		auto topology = GetTopology();
+		if (auto entry = topology->FindByPort(portId))
+			return entry->DisplayId;
 		NvU32 displayId = 0;
 		
 		if (auto err = NvAPI_SYS_GetDisplayIdFromGpuAndOutputId((NvPhysicalGpuHandle)portId.GPUId, portId.PortId, &displayId); err != NVAPI_OK)
@@ -41,22 +89,33 @@ struct NVIDIACustomResolution : CustomResolutionBase
 		return displayId;
 	}
 
-	bool SetResolutionAndRefreshRate(GPUPortIdentifier portId, CustomResolutionInfo info) override
+	std::optional<NV_CUSTOM_DISPLAY> MakeCustomDisplay(GPUPortIdentifier portId, NvU32 dispId, CustomResolutionInfo const& info)
 	{
-		auto dispId = GetDisplayIdFromPort(portId);
-		if (!dispId)
-			return false;
-		NV_TIMING_INPUT timing{ .version = NV_TIMING_INPUT_VER };
-		timing.rr = info.RefreshRate;
-		timing.width = info.Resolution.x;
-		timing.height = info.Resolution.y;
-		timing.flag.scaling = 1;
-		timing.type = NV_TIMING_OVERRIDE_AUTO;
 		NV_CUSTOM_DISPLAY customDisplay{ .version = NV_CUSTOM_DISPLAY_VER };
-		if (auto err = NvAPI_DISP_GetTiming(dispId.value(), &timing, &customDisplay.timing); err != NVAPI_OK)
+		// Without an EDID to choose from, Auto takes the driver's timing
+		if (info.Standard == TimingStandard::Auto && !GetCapabilities(portId))
 		{
-			nosEngine.LogE("Failed to get timing: %s", GetErrorString(err).c_str());
-			return false;
+			NV_TIMING_INPUT timing{ .version = NV_TIMING_INPUT_VER };
+			timing.rr = info.RefreshRate;
+			timing.width = info.Resolution.x;
+			timing.height = info.Resolution.y;
+			timing.flag.scaling = 1;
+			timing.type = NV_TIMING_OVERRIDE_AUTO;
+			if (auto err = NvAPI_DISP_GetTiming(dispId, &timing, &customDisplay.timing); err != NVAPI_OK)
+			{
+				nosEngine.LogE("Failed to get timing: %s", GetErrorString(err).c_str());
+				return std::nullopt;
+			}
+			if (!ValidateTiming(portId, info, FromNVTiming(customDisplay.timing)))
+				return std::nullopt;
+		}
+		else
+		{
+			// Submitted as is, the driver is not asked for a timing of its own
+			auto timing = ResolveTiming(portId, info);
+			if (!timing)
+				return std::nullopt;
+			customDisplay.timing = ToNVTiming(*timing, TimingStandardNames[uint32_t(info.Standard)]);
 		}
 		customDisplay.width = info.Resolution.x;
 		customDisplay.height = info.Resolution.y;
@@ -68,7 +127,7 @@ struct NVIDIACustomResolution : CustomResolutionBase
 				break;
 			default:
 				nosEngine.LogE("Unsupported color format: %d", info.ColorFormat);
-				return false;
+				return std::nullopt;
 		}
 		customDisplay.srcPartition.x = 0;
 		customDisplay.srcPartition.y = 0;
@@ -76,28 +135,52 @@ struct NVIDIACustomResolution : CustomResolutionBase
 		customDisplay.srcPartition.w = 1;
 		customDisplay.xRatio = 1;
 		customDisplay.yRatio = 1;
+		return customDisplay;
+	}
+
+protected:
+	// Every display of the transaction goes through a single trial and save, the driver changes them together
+	bool ApplyModes(std::vector<CustomResolutionRequest> const& requests) override
+	{
+		std::vector<NvU32> dispIds;
+		std::vector<NV_CUSTOM_DISPLAY> customDisplays;
+		for (auto& request : requests)
+		{
+			auto dispId = GetDisplayIdFromPort(request.Port);
+			if (!dispId)
+				return false;
+			auto customDisplay = MakeCustomDisplay(request.Port, *dispId, request.Info);
+			if (!customDisplay)
+				return false;
+			dispIds.push_back(*dispId);
+			customDisplays.push_back(*customDisplay);
+		}
 
-		if (auto err = NvAPI_DISP_TryCustomDisplay(&dispId.value(), 1, &customDisplay); err != NVAPI_OK)
+		if (auto err = NvAPI_DISP_TryCustomDisplay(dispIds.data(), NvU32(dispIds.size()), customDisplays.data()); err != NVAPI_OK)
 		{
 			nosEngine.LogE("Failed to try custom display: %s", GetErrorString(err).c_str());
 			return false;
 		}
 
-		if (auto err = NvAPI_DISP_SaveCustomDisplay(&dispId.value(), 1, true, true); err != NVAPI_OK)
+		if (auto err = NvAPI_DISP_SaveCustomDisplay(dispIds.data(), NvU32(dispIds.size()), true, true); err != NVAPI_OK)
 		{
-			RevertResolution(portId);
 			nosEngine.LogE("Failed to save custom display: %s", GetErrorString(err).c_str());
 			return false;
 		}
 		return true;
 	}
 
-	bool RevertResolution(GPUPortIdentifier portId) override
+	bool RevertModes(std::vector<GPUPortIdentifier> const& portIds) override
 	{
-		auto dispId = GetDisplayIdFromPort(portId);
-		if (!dispId)
-			return false;
-		if (auto err = NvAPI_DISP_RevertCustomDisplayTrial(&dispId.value(), 1); err != NVAPI_OK)
+		std::vector<NvU32> dispIds;
+		for (auto& portId : portIds)
+		{
+			auto dispId = GetDisplayIdFromPort(portId);
+			if (!dispId)
+				return false;
+			dispIds.push_back(*dispId);
+		}
+		if (auto err = NvAPI_DISP_RevertCustomDisplayTrial(dispIds.data(), NvU32(dispIds.size())); err != NVAPI_OK)
 		{
 			nosEngine.LogE("Failed to revert custom display: %s", GetErrorString(err).c_str());
 			return false;
@@ -105,23 +188,73 @@ struct NVIDIACustomResolution : CustomResolutionBase
 		return true;
 	}
 
-	std::optional<std::string> GetAdapterName(GPUPortIdentifier portId, std::vector<std::string> const& possibleAdapterNames) override
+	std::optional<DisplayTiming> GetCurrentTiming(GPUPortIdentifier portId) override
 	{
-		auto id = GetDisplayIdFromPort(portId);
-		if (!id)
+		auto dispId = GetDisplayIdFromPort(portId);
+		if (!dispId)
 			return std::nullopt;
-		for (auto& adapterName : possibleAdapterNames)
+		// Three passes: the path count, the target count of each path, then the paths with their targets
+		NvU32 pathCount = 0;
+		if (auto err = NvAPI_DISP_GetDisplayConfig(&pathCount, nullptr); err != NVAPI_OK)
 		{
-			NvU32 curDispId{};
-			if(auto err = NvAPI_DISP_GetDisplayIdByDisplayName(adapterName.c_str(), &curDispId); err != NVAPI_OK)
-				continue;
-			if (id.value() == curDispId)
-				return adapterName;
+			nosEngine.LogE("Failed to get display config: %s", GetErrorString(err).c_str());
+			return std::nullopt;
+		}
+		std::vector<NV_DISPLAYCONFIG_PATH_INFO> paths(pathCount);
+		for (auto& path : paths)
+			path.version = NV_DISPLAYCONFIG_PATH_INFO_VER;
+		if (auto err = NvAPI_DISP_GetDisplayConfig(&pathCount, paths.data()); err != NVAPI_OK)
+		{
+			nosEngine.LogE("Failed to get display config: %s", GetErrorString(err).c_str());
+			return std::nullopt;
 		}
+		std::vector<std::vector<NV_DISPLAYCONFIG_PATH_TARGET_INFO>> targets(pathCount);
+		std::vector<std::vector<NV_DISPLAYCONFIG_PATH_ADVANCED_TARGET_INFO>> details(pathCount);
+		std::vector<NV_DISPLAYCONFIG_SOURCE_MODE_INFO> sourceModes(pathCount);
+		for (NvU32 i = 0; i < pathCount; ++i)
+		{
+			targets[i].resize(paths[i].targetInfoCount);
+			details[i].resize(paths[i].targetInfoCount);
+			for (NvU32 j = 0; j < paths[i].targetInfoCount; ++j)
+			{
+				details[i][j].version = NV_DISPLAYCONFIG_PATH_ADVANCED_TARGET_INFO_VER;
+				targets[i][j].details = &details[i][j];
+			}
+			paths[i].targetInfo = targets[i].data();
+			paths[i].sourceModeInfo = &sourceModes[i];
+		}
+		if (auto err = NvAPI_DISP_GetDisplayConfig(&pathCount, paths.data()); err != NVAPI_OK)
+		{
+			nosEngine.LogE("Failed to get display config: %s", GetErrorString(err).c_str());
+			return std::nullopt;
+		}
+		for (NvU32 i = 0; i < pathCount; ++i)
+			for (auto& target : targets[i])
+				if (target.displayId == *dispId)
+					return FromNVTiming(target.details->timing);
 		return std::nullopt;
 	}
 
-	std::optional<GPUPortIdentifier> GetGPUPortIdFromAdapterName(const char* adapterName) override
+	std::optional<std::vector<uint8_t>> ReadEDID(GPUPortIdentifier portId) override
+	{
+		// Comes in chunks of NV_EDID_DATA_SIZE, the first one tells the full size
+		NV_EDID edid{ .version = NV_EDID_VER };
+		std::vector<uint8_t> result;
+		do
+		{
+			edid.offset = NvU32(result.size());
+			if (auto err = NvAPI_GPU_GetEDID((NvPhysicalGpuHandle)portId.GPUId, portId.PortId, &edid); err != NVAPI_OK)
+			{
+				nosEngine.LogW("Failed to read EDID of port %u: %s", portId.PortId, GetErrorString(err).c_str());
+				return std::nullopt;
+			}
+			size_t chunkSize = std::min<size_t>(NV_EDID_DATA_SIZE, edid.sizeofEDID - result.size());
+			result.insert(result.end(), edid.EDID_Data, edid.EDID_Data + chunkSize);
+		} while (result.size() < edid.sizeofEDID);
+		return result;
+	}
+
+	std::optional<uint32_t> GetDisplayIdFromAdapterName(const char* adapterName) override
 	{
 		NvU32 displayId{};
 		if (auto err = NvAPI_DISP_GetDisplayIdByDisplayName(adapterName, &displayId); err != NVAPI_OK)
@@ -129,6 +262,11 @@ struct NVIDIACustomResolution : CustomResolutionBase
 			nosEngine.LogE("Failed to get display id by display name: %s", GetErrorString(err).c_str());
 			return std::nullopt;
 		}
+		return displayId;
+	}
+
+	std::optional<GPUPortIdentifier> GetPortFromDisplayId(uint32_t displayId) override
+	{
 		NvPhysicalGpuHandle gpuHandle{};
 		NvU32 portId{};
 		if (auto err = NvAPI_SYS_GetGpuAndOutputIdFromDisplayId(displayId, &gpuHandle, &portId); err != NVAPI_OK)
@@ -139,7 +277,18 @@ struct NVIDIACustomResolution : CustomResolutionBase
 		return GPUPortIdentifier{ .GPUId = gpuHandle, .PortId = portId };
 	}
 
-	std::vector<GPUPortIdentifier> GetActivePortIds()
+	std::optional<uint32_t> GetGPUBusId(void* gpuId) override
+	{
+		NvU32 busId{};
+		if (auto err = NvAPI_GPU_GetBusId((NvPhysicalGpuHandle)gpuId, &busId); err != NVAPI_OK)
+		{
+			nosEngine.LogE("Failed to get GPU bus id: %s", GetErrorString(err).c_str());
+			return std::nullopt;
+		}
+		return busId;
+	}
+
+	std::vector<DisplayPortInfo> EnumerateActiveDisplays() override
 	{
 		NvPhysicalGpuHandle nvGPUHandle[NVAPI_MAX_PHYSICAL_GPUS]{};
 		NvU32 gpuCount = 0;
@@ -151,7 +300,7 @@ struct NVIDIACustomResolution : CustomResolutionBase
 			return {};
 		}
 
-		std::vector<GPUPortIdentifier> result;
+		std::vector<DisplayPortInfo> result;
 		for (uint32_t gpuIndex = 0; gpuIndex < gpuCount; gpuIndex++)
 		{
 			NvU32 dispIdCount = 0;
@@ -185,7 +334,7 @@ struct NVIDIACustomResolution : CustomResolutionBase
 					nosEngine.LogE("Failed to get gpu and port id: %s", GetErrorString(err).c_str());
 					continue;
 				}
-				result.push_back(GPUPortIdentifier{ .GPUId = gpuHandle, .PortId = portId });
+				result.push_back({ .Port = { .GPUId = gpuHandle, .PortId = portId }, .DisplayId = dispId.displayId });
 			}
 		}
 		return result;
@@ -196,4 +345,5 @@ std::unique_ptr<CustomResolutionBase> TryCreateNVIDIACustomResolution()
 {
 	return std::make_unique<NVIDIACustomResolution>();
 }
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,222 @@
+#include "PresentBackend.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace nos::display
+{
+const char* GetPresentModeName(nosPresentMode mode)
+{
+	for (auto& info : LatencyOrderedPresentModes)
+		if (info.Mode == mode)
+			return info.Name;
+	return "Unknown";
+}
+
+std::optional<nosPresentMode> ParsePresentMode(std::string_view name)
+{
+	for (auto& info : LatencyOrderedPresentModes)
+		if (name == info.Name)
+			return info.Mode;
+	return std::nullopt;
+}
+
+std::optional<nosPresentMode> CreateSwapchainWithFallback(PresentBackend& backend, nosVec2u extent, nosPresentMode requested,
+														  std::vector<nosResourceShareInfo>& outImages)
+{
+	// From the requested mode towards FIFO, the first mode the surface supports has the lowest latency left
+	auto first = std::find_if(std::begin(LatencyOrderedPresentModes), std::end(LatencyOrderedPresentModes), [&](PresentModeInfo const& info) { return info.Mode == requested; });
+	if (first == std::end(LatencyOrderedPresentModes))
+		first = std::prev(first);
+	for (auto mode = first; mode != std::end(LatencyOrderedPresentModes); ++mode)
+		if ((mode->Mode == NOS_PRESENT_MODE_FIFO || backend.IsPresentModeSupported(mode->Mode)) && backend.CreateSwapchain(extent, mode->Mode, outImages))
+			return mode->Mode;
+	return std::nullopt;
+}
+
+struct VulkanPresentBackend : PresentBackend
+{
+	~VulkanPresentBackend() override
+	{
+		DestroySwapchain();
+		DestroySurface();
+	}
+
+	bool CreateSurface(void* windowHandle) override
+	{
+		RefusedPresentModes.clear();
+		return nosVulkan->CreateWindowSurface(windowHandle, &Surface) == NOS_RESULT_SUCCESS;
+	}
+
+	void DestroySurface() override
+	{
+		if (!Surface)
+			return;
+		nosVulkan->DestroyWindowSurface(&Surface);
+	}
+
+	bool HasSurface() const override { return Surface; }
+
+	// The vulkan subsystem does not expose the modes a surface supports. Each mode other than FIFO is tried once on a surface,
+	// a mode the subsystem refuses is not requested again, its swapchains are created in the next mode that works instead.
+	bool IsPresentModeSupported(nosPresentMode presentMode) const override
+	{
+		return presentMode == NOS_PRESENT_MODE_FIFO || std::find(RefusedPresentModes.begin(), RefusedPresentModes.end(), presentMode) == RefusedPresentModes.end();
+	}
+
+	bool CreateSwapchain(nosVec2u extent, nosPresentMode presentMode, std::vector<nosResourceShareInfo>& outImages) override
+	{
+		nosSwapchainCreateInfo createInfo = {};
+		createInfo.SurfaceHandle = Surface;
+		createInfo.Extent = extent;
+		createInfo.PresentMode = presentMode;
+		// The surface still has the retired swapchain, the new one takes over from it
+		createInfo.OldSwapchain = OldSwapchain;
+		uint32_t imageCount = 0;
+		if (nosVulkan->CreateSwapchain(&createInfo, &Swapchain, &imageCount) != NOS_RESULT_SUCCESS)
+		{
+			if (presentMode != NOS_PRESENT_MODE_FIFO)
+				RefusedPresentModes.push_back(presentMode);
+			return false;
+		}
+		OldSwapchain = {};
+		outImages.resize(imageCount);
+		nosVulkan->GetSwapchainImages(Swapchain, outImages.data());
+		return true;
+	}
+
+	void DestroySwapchain() override
+	{
+		if (!Swapchain)
+			return;
+		nosVulkan->DestroySwapchain(&Swapchain);
+	}
+
+	bool HasSwapchain() const override { return Swapchain; }
+
+	nosSwapchainHandle RetireSwapchain() override
+	{
+		OldSwapchain = Swapchain;
+		return std::exchange(Swapchain, {});
+	}
+
+	void DestroyRetiredSwapchain(nosSwapchainHandle& swapchain) override
+	{
+		if (!swapchain)
+			return;
+		if (swapchain == OldSwapchain)
+			OldSwapchain = {};
+		nosVulkan->DestroySwapchain(&swapchain);
+		swapchain = {};
+	}
+
+	nosResult AcquireNextImage(uint64_t timeout, uint32_t* outImageIndex, nosSemaphore waitSemaphore) override
+	{
+		return nosVulkan->SwapchainAcquireNextImage(Swapchain, timeout, outImageIndex, waitSemaphore);
+	}
+
+	nosResult Present(uint32_t imageIndex, nosSemaphore signalSemaphore) override
+	{
+		return nosVulkan->SwapchainPresent(Swapchain, imageIndex, signalSemaphore);
+	}
+
+	nosSemaphore CreateFrameSemaphore() override
+	{
+		nosSemaphoreCreateInfo semaphoreCreateInfo = {};
+		semaphoreCreateInfo.Type = NOS_SEMAPHORE_TYPE_BINARY;
+		nosSemaphore semaphore{};
+#ifdef CreateSemaphore
+#undef CreateSemaphore
+#endif
+		nosVulkan->CreateSemaphore(&semaphoreCreateInfo, &semaphore);
+		return semaphore;
+	}
+
+	void DestroyFrameSemaphore(nosSemaphore& semaphore) override
+	{
+		if (!semaphore)
+			return;
+		nosVulkan->DestroySemaphore(&semaphore);
+		semaphore = {};
+	}
+
+	bool IsHeadless() const override { return false; }
+
+	nosSurfaceHandle Surface{};
+	nosSwapchainHandle Swapchain{};
+	nosSwapchainHandle OldSwapchain{}; // Retired and not replaced yet
+	std::vector<nosPresentMode> RefusedPresentModes;
+};
+
+std::unique_ptr<PresentBackend> CreateVulkanPresentBackend()
+{
+	return std::make_unique<VulkanPresentBackend>();
+}
+
+bool NullPresentBackend::CreateSurface(void*)
+{
+	SurfaceCreated = true;
+	return true;
+}
+
+void NullPresentBackend::DestroySurface()
+{
+	SurfaceCreated = false;
+}
+
+bool NullPresentBackend::IsPresentModeSupported(nosPresentMode presentMode) const
+{
+	return std::find(SupportedPresentModes.begin(), SupportedPresentModes.end(), presentMode) != SupportedPresentModes.end();
+}
+
+bool NullPresentBackend::CreateSwapchain(nosVec2u extent, nosPresentMode presentMode, std::vector<nosResourceShareInfo>& outImages)
+{
+	if (!SurfaceCreated || extent.x == 0 || extent.y == 0 || !IsPresentModeSupported(presentMode))
+		return false;
+	ImageCount = presentMode == NOS_PRESENT_MODE_MAILBOX ? 3 : 2;
+	NextImage = 0;
+	OutOfDate = false;
+	Extent = extent;
+	PresentMode = presentMode;
+	outImages.assign(ImageCount, nosResourceShareInfo{});
+	for (auto& image : outImages)
+	{
+		image.Info.Type = NOS_RESOURCE_TYPE_TEXTURE;
+		image.Info.Texture.Width = extent.x;
+		image.Info.Texture.Height = extent.y;
+		image.Info.Texture.Format = NOS_FORMAT_B8G8R8A8_UNORM;
+	}
+	++SwapchainsCreated;
+	return true;
+}
+
+void NullPresentBackend::DestroySwapchain()
+{
+	ImageCount = 0;
+}
+
+nosSwapchainHandle NullPresentBackend::RetireSwapchain()
+{
+	DestroySwapchain();
+	return {};
+}
+
+nosResult NullPresentBackend::AcquireNextImage(uint64_t, uint32_t* outImageIndex, nosSemaphore)
+{
+	if (!ImageCount)
+		return NOS_RESULT_FAILED;
+	if (Stalled)
+		return NOS_RESULT_TIMEOUT;
+	*outImageIndex = NextImage;
+	NextImage = (NextImage + 1) % ImageCount;
+	return NOS_RESULT_SUCCESS;
+}
+
+nosResult NullPresentBackend::Present(uint32_t imageIndex, nosSemaphore)
+{
+	if (!ImageCount || imageIndex >= ImageCount || OutOfDate)
+		return NOS_RESULT_FAILED;
+	++FramesPresented;
+	return NOS_RESULT_SUCCESS;
+}
+}
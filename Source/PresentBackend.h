@@ -0,0 +1,108 @@
+#pragma once
+
+#include <Nodos/PluginHelpers.hpp>
+#include <nosVulkanSubsystem/nosVulkanSubsystem.h>
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace nos::display
+{
+struct PresentModeInfo
+{
+	nosPresentMode Mode;
+	const char* Name;
+};
+
+// From lowest to highest latency. FIFO is the only mode every surface supports, an unsupported mode falls back to the
+// next one in this order.
+inline constexpr PresentModeInfo LatencyOrderedPresentModes[] = {
+	{ NOS_PRESENT_MODE_IMMEDIATE, "Immediate" },
+	{ NOS_PRESENT_MODE_MAILBOX, "Mailbox" },
+	{ NOS_PRESENT_MODE_FIFO_RELAXED, "FIFO Relaxed" },
+	{ NOS_PRESENT_MODE_FIFO, "FIFO" },
+};
+
+const char* GetPresentModeName(nosPresentMode mode);
+std::optional<nosPresentMode> ParsePresentMode(std::string_view name);
+
+// Surface and swapchain lifecycle of a DisplayOut, so the node can run without a window or a GPU surface.
+struct PresentBackend
+{
+	virtual ~PresentBackend() = default;
+
+	virtual bool CreateSurface(void* windowHandle) = 0;
+	virtual void DestroySurface() = 0;
+	virtual bool HasSurface() const = 0;
+
+	// FIFO is always supported. Modes reported as unsupported are never passed to CreateSwapchain.
+	virtual bool IsPresentModeSupported(nosPresentMode presentMode) const = 0;
+	virtual bool CreateSwapchain(nosVec2u extent, nosPresentMode presentMode, std::vector<nosResourceShareInfo>& outImages) = 0;
+	virtual void DestroySwapchain() = 0;
+	virtual bool HasSwapchain() const = 0;
+	// Hands over the swapchain without destroying it, for presents still queued on it. The backend has no swapchain
+	// until the next CreateSwapchain, which replaces the retired one. Returns an empty handle if there is nothing to
+	// destroy later.
+	virtual nosSwapchainHandle RetireSwapchain() = 0;
+	// Once every present queued on it has completed
+	virtual void DestroyRetiredSwapchain(nosSwapchainHandle& swapchain) = 0;
+
+	// NOS_RESULT_TIMEOUT if no image became available within timeout (in nanoseconds)
+	virtual nosResult AcquireNextImage(uint64_t timeout, uint32_t* outImageIndex, nosSemaphore waitSemaphore) = 0;
+	// Anything other than NOS_RESULT_SUCCESS means the swapchain is out of date and should be recreated.
+	virtual nosResult Present(uint32_t imageIndex, nosSemaphore signalSemaphore) = 0;
+
+	virtual nosSemaphore CreateFrameSemaphore() = 0;
+	virtual void DestroyFrameSemaphore(nosSemaphore& semaphore) = 0;
+
+	// Images of a headless backend are not backed by GPU memory, nothing should be recorded for them.
+	virtual bool IsHeadless() const = 0;
+};
+
+std::unique_ptr<PresentBackend> CreateVulkanPresentBackend();
+
+// Creates a swapchain in the requested mode if the backend supports it, otherwise in the next mode of
+// LatencyOrderedPresentModes that it supports, down to FIFO. Returns the mode created.
+std::optional<nosPresentMode> CreateSwapchainWithFallback(PresentBackend& backend, nosVec2u extent, nosPresentMode requested,
+														  std::vector<nosResourceShareInfo>& outImages);
+
+struct NullPresentBackend : PresentBackend
+{
+	bool CreateSurface(void* windowHandle) override;
+	void DestroySurface() override;
+	bool HasSurface() const override { return SurfaceCreated; }
+
+	bool IsPresentModeSupported(nosPresentMode presentMode) const override;
+	bool CreateSwapchain(nosVec2u extent, nosPresentMode presentMode, std::vector<nosResourceShareInfo>& outImages) override;
+	void DestroySwapchain() override;
+	bool HasSwapchain() const override { return ImageCount != 0; }
+	// Headless swapchains have no handle, they are gone once retired
+	nosSwapchainHandle RetireSwapchain() override;
+	void DestroyRetiredSwapchain(nosSwapchainHandle& swapchain) override { swapchain = {}; }
+
+	nosResult AcquireNextImage(uint64_t timeout, uint32_t* outImageIndex, nosSemaphore waitSemaphore) override;
+	nosResult Present(uint32_t imageIndex, nosSemaphore signalSemaphore) override;
+
+	nosSemaphore CreateFrameSemaphore() override { return {}; }
+	void DestroyFrameSemaphore(nosSemaphore& semaphore) override { semaphore = {}; }
+
+	bool IsHeadless() const override { return true; }
+
+	// The next Present reports the swapchain as out of date, like a resized or lost surface would.
+	void MarkOutOfDate() { OutOfDate = true; }
+	// Acquires time out while stalled, like with a hung compositor or presentation engine.
+	void SetStalled(bool stalled) { Stalled = stalled; }
+
+	uint32_t ImageCount = 0;
+	uint32_t NextImage = 0;
+	bool SurfaceCreated = false;
+	bool OutOfDate = false;
+	bool Stalled = false;
+	nosVec2u Extent{};
+	nosPresentMode PresentMode{};
+	std::vector<nosPresentMode> SupportedPresentModes = { NOS_PRESENT_MODE_IMMEDIATE, NOS_PRESENT_MODE_MAILBOX, NOS_PRESENT_MODE_FIFO_RELAXED, NOS_PRESENT_MODE_FIFO };
+	uint64_t SwapchainsCreated = 0;
+	uint64_t FramesPresented = 0;
+};
+}
@@ -0,0 +1,151 @@
+#include "PresentPass.h"
+
+#include <nosVulkanSubsystem/Helpers.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+namespace nos::display
+{
+std::optional<PresentScaleMode> ParsePresentScaleMode(std::string_view name)
+{
+	for (uint32_t i = 0; i < std::size(PresentScaleModeNames); ++i)
+		if (name == PresentScaleModeNames[i])
+			return PresentScaleMode(i);
+	return std::nullopt;
+}
+
+std::optional<PresentRotation> ParsePresentRotation(std::string_view name)
+{
+	for (uint32_t i = 0; i < std::size(PresentRotationNames); ++i)
+		if (name == PresentRotationNames[i])
+			return PresentRotation(i);
+	return std::nullopt;
+}
+
+bool PresentPassSettings::HasTransform() const
+{
+	return !SourceRect.IsEmpty() || Rotation != PresentRotation::None || FlipHorizontal || FlipVertical || OffsetX || OffsetY;
+}
+
+nosVec2u GetRotatedExtent(nosVec2u extent, PresentRotation rotation)
+{
+	if (rotation == PresentRotation::Rotate90 || rotation == PresentRotation::Rotate270)
+		return { extent.y, extent.x };
+	return extent;
+}
+
+PresentRect ClampSourceRect(PresentRect rect, nosVec2u inputExtent)
+{
+	float x = std::clamp(rect.X, 0.0f, float(inputExtent.x));
+	float y = std::clamp(rect.Y, 0.0f, float(inputExtent.y));
+	return { x, y, std::clamp(rect.Width, 0.0f, inputExtent.x - x), std::clamp(rect.Height, 0.0f, inputExtent.y - y) };
+}
+
+PresentRect ComputePresentRect(nosVec2u inputExtent, nosVec2u outputExtent, PresentScaleMode scaleMode, bool letterbox)
+{
+	if (!inputExtent.x || !inputExtent.y)
+		return { 0, 0, float(outputExtent.x), float(outputExtent.y) };
+	float scaleX = float(outputExtent.x) / inputExtent.x;
+	float scaleY = float(outputExtent.y) / inputExtent.y;
+	if (scaleMode == PresentScaleMode::Integer)
+	{
+		// Integer factor when enlarging, integer divisor when shrinking
+		float fit = std::min(scaleX, scaleY);
+		scaleX = scaleY = fit >= 1.0f ? std::floor(fit) : 1.0f / std::ceil(1.0f / fit);
+	}
+	else if (letterbox)
+	{
+		scaleX = scaleY = std::min(scaleX, scaleY);
+	}
+	PresentRect rect;
+	rect.Width = std::round(inputExtent.x * scaleX);
+	rect.Height = std::round(inputExtent.y * scaleY);
+	rect.X = std::floor((outputExtent.x - rect.Width) * 0.5f);
+	rect.Y = std::floor((outputExtent.y - rect.Height) * 0.5f);
+	return rect;
+}
+
+// Set once the shader and the pass are registered, RecordPresentPass only copies without them
+static bool PresentPassRegistered = false;
+
+nosResult RegisterPresentPass()
+{
+	PresentPassRegistered = false;
+	auto shaderPath = (std::filesystem::path(nosEngine.Module->RootFolderPath) / "Shaders" / "DisplayOutPresent.frag").generic_string();
+	nosShaderInfo shader = {
+		.ShaderName = NOS_NAME_STATIC("nos.display.PresentShader"),
+		.Source = { .Stage = NOS_SHADER_STAGE_FRAG, .GLSLPath = shaderPath.c_str() },
+		.AssociatedNodeClassName = NOS_NAME_STATIC("DisplayOut"),
+	};
+	if (auto res = nosVulkan->RegisterShaders(1, &shader); res != NOS_RESULT_SUCCESS)
+		return res;
+	nosPassInfo pass = {
+		.Key = NOS_NAME_STATIC("nos.display.PresentPass"),
+		.Shader = NOS_NAME_STATIC("nos.display.PresentShader"),
+		.MultiSample = 1,
+	};
+	if (auto res = nosVulkan->RegisterPasses(1, &pass); res != NOS_RESULT_SUCCESS)
+		return res;
+	PresentPassRegistered = true;
+	return NOS_RESULT_SUCCESS;
+}
+
+static bool IsEightBitFormat(nosFormat format)
+{
+	switch (format)
+	{
+	case NOS_FORMAT_B8G8R8A8_UNORM:
+	case NOS_FORMAT_B8G8R8A8_SRGB:
+	case NOS_FORMAT_R8G8B8A8_UNORM:
+	case NOS_FORMAT_R8G8B8A8_SRGB:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void RecordPresentPass(nosCmd cmd, nosResourceShareInfo const& input, nosResourceShareInfo const& output, PresentPassSettings const& settings)
+{
+	auto& in = input.Info.Texture;
+	auto& out = output.Info.Texture;
+	// A crop reaching beyond the input would sample outside of it, only the part inside the input is presented
+	auto source = ClampSourceRect(settings.SourceRect, { in.Width, in.Height });
+	if (source.IsEmpty())
+		source = { 0, 0, float(in.Width), float(in.Height) };
+	bool wholeInput = source == PresentRect{ 0, 0, float(in.Width), float(in.Height) };
+	bool plainCopy = wholeInput && settings.Rotation == PresentRotation::None && !settings.FlipHorizontal && !settings.FlipVertical &&
+					 !settings.OffsetX && !settings.OffsetY && in.Width == out.Width && in.Height == out.Height && in.Format == out.Format;
+	// Without the pass the copy blits the whole input over the output, converting its format but dropping every transform
+	if (plainCopy || !PresentPassRegistered)
+	{
+		nosVulkan->Copy(cmd, &input, &output, 0);
+		return;
+	}
+	auto sourceExtent = GetRotatedExtent({ uint32_t(source.Width), uint32_t(source.Height) }, settings.Rotation);
+	auto rect = ComputePresentRect(sourceExtent, { out.Width, out.Height }, settings.ScaleMode, settings.Letterbox);
+	nosVec4 destRect = { rect.X + settings.OffsetX, rect.Y + settings.OffsetY, rect.Width, rect.Height };
+	nosVec4 sourceRect = { source.X, source.Y, source.Width, source.Height };
+	uint32_t scaleMode = uint32_t(settings.ScaleMode);
+	uint32_t rotation = uint32_t(settings.Rotation);
+	uint32_t flip = (settings.FlipHorizontal ? 1u : 0u) | (settings.FlipVertical ? 2u : 0u);
+	uint32_t dither = settings.Dither && in.Format != out.Format && !IsEightBitFormat(in.Format) && IsEightBitFormat(out.Format);
+	nosShaderBinding bindings[] = {
+		vkss::ShaderBinding(NOS_NAME_STATIC("Input"), input),
+		vkss::ShaderBinding(NOS_NAME_STATIC("DestRect"), destRect),
+		vkss::ShaderBinding(NOS_NAME_STATIC("SourceRect"), sourceRect),
+		vkss::ShaderBinding(NOS_NAME_STATIC("ScaleMode"), scaleMode),
+		vkss::ShaderBinding(NOS_NAME_STATIC("Dither"), dither),
+		vkss::ShaderBinding(NOS_NAME_STATIC("Rotation"), rotation),
+		vkss::ShaderBinding(NOS_NAME_STATIC("Flip"), flip),
+	};
+	nosRunPassParams pass = {};
+	pass.Key = NOS_NAME_STATIC("nos.display.PresentPass");
+	pass.Bindings = bindings;
+	pass.BindingCount = uint32_t(std::size(bindings));
+	pass.Output = output;
+	pass.ClearColor = { 0, 0, 0, 1 };
+	nosVulkan->RunPass(cmd, &pass);
+}
+}
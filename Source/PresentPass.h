@@ -0,0 +1,71 @@
+#pragma once
+
+#include <Nodos/PluginHelpers.hpp>
+#include <nosVulkanSubsystem/nosVulkanSubsystem.h>
+
+#include <optional>
+#include <string_view>
+
+namespace nos::display
+{
+enum class PresentScaleMode : uint32_t
+{
+	Nearest,
+	Bilinear,
+	Integer, // Nearest at the largest integer factor that fits, always aspect preserving
+};
+
+inline constexpr const char* PresentScaleModeNames[] = { "Nearest", "Bilinear", "Integer" };
+
+std::optional<PresentScaleMode> ParsePresentScaleMode(std::string_view name);
+
+// Clockwise, as seen on the output
+enum class PresentRotation : uint32_t
+{
+	None,
+	Rotate90,
+	Rotate180,
+	Rotate270,
+};
+
+inline constexpr const char* PresentRotationNames[] = { "0", "90", "180", "270" };
+
+std::optional<PresentRotation> ParsePresentRotation(std::string_view name);
+
+// Placement of the input in the output, in output pixels
+struct PresentRect
+{
+	float X = 0, Y = 0, Width = 0, Height = 0;
+	bool IsEmpty() const { return Width <= 0 || Height <= 0; }
+	bool operator==(const PresentRect&) const = default;
+};
+
+struct PresentPassSettings
+{
+	PresentScaleMode ScaleMode = PresentScaleMode::Bilinear;
+	bool Letterbox = false;
+	bool Dither = true;
+	PresentRect SourceRect{}; // Part of the input to present, in input pixels. Empty presents the whole input.
+	PresentRotation Rotation = PresentRotation::None;
+	bool FlipHorizontal = false; // Applied after the rotation, as seen on the output
+	bool FlipVertical = false;
+	int32_t OffsetX = 0, OffsetY = 0; // Shift of the placement in the output, in output pixels
+	bool HasTransform() const;
+};
+
+// Extent of the source once rotated onto the output
+nosVec2u GetRotatedExtent(nosVec2u extent, PresentRotation rotation);
+
+// Limits a source rect to the input, a rect entirely outside of it comes back empty
+PresentRect ClampSourceRect(PresentRect rect, nosVec2u inputExtent);
+
+PresentRect ComputePresentRect(nosVec2u inputExtent, nosVec2u outputExtent, PresentScaleMode scaleMode, bool letterbox);
+
+// Registers the shader and pass used by RecordPresentPass, once per plugin load.
+nosResult RegisterPresentPass();
+
+// Writes an input into a swapchain image in one pass over the pixels: a plain copy when extent and format match,
+// otherwise a single draw that crops, rotates, scales, letterboxes and converts the format (dithering down to 8 bits
+// per channel). Until RegisterPresentPass succeeded it always copies, stretching the input without its transforms.
+void RecordPresentPass(nosCmd cmd, nosResourceShareInfo const& input, nosResourceShareInfo const& output, PresentPassSettings const& settings);
+}
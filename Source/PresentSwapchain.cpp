@@ -0,0 +1,59 @@
+#include "PresentSwapchain.h"
+
+namespace nos::display
+{
+std::optional<nosPresentMode> PresentSwapchain::Create(PresentBackend& backend, nosVec2u extent, nosPresentMode presentMode, uint32_t frameSlots, bool acquireAhead)
+{
+	Backend = &backend;
+	auto createdMode = CreateSwapchainWithFallback(backend, extent, presentMode, Images);
+	if (!createdMode)
+	{
+		Images.clear();
+		return std::nullopt;
+	}
+	Extent = extent;
+	auto createSemaphores = [&](std::vector<nosSemaphore>& semaphores, size_t count) {
+		semaphores.resize(count);
+		for (auto& semaphore : semaphores)
+			semaphore = backend.CreateFrameSemaphore();
+	};
+	createSemaphores(AcquireSemaphores, frameSlots);
+	createSemaphores(AcquireAheadSemaphores, acquireAhead ? frameSlots : 0);
+	createSemaphores(PresentSemaphores, Images.size());
+	return createdMode;
+}
+
+void PresentSwapchain::Retire(uint64_t releaseAfterFrame)
+{
+	if (!Backend || !Backend->HasSwapchain())
+		return;
+	RetiredSwapchain retired{ .ReleaseAfterFrame = releaseAfterFrame, .Swapchain = Backend->RetireSwapchain() };
+	for (auto semaphores : { &AcquireSemaphores, &AcquireAheadSemaphores, &PresentSemaphores })
+	{
+		retired.Semaphores.insert(retired.Semaphores.end(), semaphores->begin(), semaphores->end());
+		semaphores->clear();
+	}
+	Retired.push_back(std::move(retired));
+	Images.clear();
+	// Nothing is submitted for headless images
+	if (Backend->IsHeadless())
+		ReleaseAllRetired();
+}
+
+void PresentSwapchain::ReleaseRetired(uint64_t completedFrames)
+{
+	std::erase_if(Retired, [&](RetiredSwapchain& retired) {
+		if (completedFrames < retired.ReleaseAfterFrame)
+			return false;
+		Backend->DestroyRetiredSwapchain(retired.Swapchain);
+		for (auto& semaphore : retired.Semaphores)
+			Backend->DestroyFrameSemaphore(semaphore);
+		return true;
+	});
+}
+
+void PresentSwapchain::ReleaseAllRetired()
+{
+	ReleaseRetired(UINT64_MAX);
+}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "PresentBackend.h"
+
+#include <optional>
+#include <vector>
+
+namespace nos::display
+{
+// Swapchain of a PresentBackend with the semaphores of its images and frame slots, shared by DisplayOut and
+// DisplayOutMulti. Acquire semaphores belong to a frame slot, present semaphores to the image they are presented with.
+// A swapchain is retired when it is rebuilt, without waiting for frames or flushing the queue: it and its semaphores are
+// only released once enough frames have completed after it for pending presents to be done with them.
+struct PresentSwapchain
+{
+	// Creates the swapchain in presentMode, or in the next supported mode towards FIFO. Returns the mode created.
+	// acquireAhead also creates a second acquire semaphore per frame slot, for images acquired before the slot is free.
+	std::optional<nosPresentMode> Create(PresentBackend& backend, nosVec2u extent, nosPresentMode presentMode, uint32_t frameSlots, bool acquireAhead = false);
+	// Hands the swapchain over to be released with its semaphores by ReleaseRetired, once frame releaseAfterFrame has
+	// completed. A swapchain must be released before the surface it was created on is destroyed.
+	void Retire(uint64_t releaseAfterFrame);
+	void ReleaseRetired(uint64_t completedFrames);
+	// Only once every frame that used them has completed, e.g. after a queue flush
+	void ReleaseAllRetired();
+	bool HasRetired() const { return !Retired.empty(); }
+
+	bool IsCreated() const { return !Images.empty(); }
+	uint32_t GetImageCount() const { return uint32_t(Images.size()); }
+
+	PresentBackend* Backend = nullptr;
+	nosVec2u Extent{};
+	std::vector<nosResourceShareInfo> Images;
+	std::vector<nosSemaphore> AcquireSemaphores;
+	std::vector<nosSemaphore> AcquireAheadSemaphores;
+	std::vector<nosSemaphore> PresentSemaphores;
+
+private:
+	struct RetiredSwapchain
+	{
+		uint64_t ReleaseAfterFrame = 0;
+		nosSwapchainHandle Swapchain{};
+		std::vector<nosSemaphore> Semaphores;
+	};
+
+	std::vector<RetiredSwapchain> Retired;
+};
+}
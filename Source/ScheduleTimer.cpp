@@ -0,0 +1,107 @@
+#include "ScheduleTimer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace nos::display
+{
+namespace
+{
+std::mutex TimerMutex;
+std::weak_ptr<ScheduleTimer> TimerInstance;
+
+bool IsSameNode(nosUUID const& a, nosUUID const& b)
+{
+	return std::memcmp(&a, &b, sizeof(nosUUID)) == 0;
+}
+}
+
+std::shared_ptr<ScheduleTimer> ScheduleTimer::Acquire()
+{
+	std::unique_lock lock(TimerMutex);
+	auto timer = TimerInstance.lock();
+	if (!timer)
+	{
+		timer = std::shared_ptr<ScheduleTimer>(new ScheduleTimer());
+		TimerInstance = timer;
+	}
+	return timer;
+}
+
+ScheduleTimer::ScheduleTimer()
+{
+	Thread = std::thread([this] { Run(); });
+}
+
+ScheduleTimer::~ScheduleTimer()
+{
+	{
+		std::unique_lock lock(Mutex);
+		StopRequested = true;
+	}
+	Changed.notify_one();
+	Thread.join();
+}
+
+void ScheduleTimer::ScheduleNodeAt(nosUUID nodeId, TimePoint time)
+{
+	Add(nodeId, time, {});
+}
+
+void ScheduleTimer::ScheduleNodeWhen(nosUUID nodeId, std::function<bool()> ready)
+{
+	Add(nodeId, SteadyPacingClock::Get().Now(), std::move(ready));
+}
+
+void ScheduleTimer::Add(nosUUID nodeId, TimePoint time, std::function<bool()> ready)
+{
+	{
+		std::unique_lock lock(Mutex);
+		auto it = std::find_if(Pending.begin(), Pending.end(), [&](PendingSchedule const& pending) { return IsSameNode(pending.NodeId, nodeId); });
+		if (it != Pending.end())
+			*it = { nodeId, time, std::move(ready) };
+		else
+			Pending.push_back({ nodeId, time, std::move(ready) });
+	}
+	Changed.notify_one();
+}
+
+void ScheduleTimer::Cancel(nosUUID nodeId)
+{
+	std::unique_lock lock(Mutex);
+	std::erase_if(Pending, [&](PendingSchedule const& pending) { return IsSameNode(pending.NodeId, nodeId); });
+}
+
+void ScheduleTimer::Run()
+{
+	std::unique_lock lock(Mutex);
+	while (!StopRequested)
+	{
+		if (Pending.empty())
+		{
+			Changed.wait(lock);
+			continue;
+		}
+		auto next = std::min_element(Pending.begin(), Pending.end(), [](PendingSchedule const& a, PendingSchedule const& b) { return a.Time < b.Time; });
+		auto now = SteadyPacingClock::Get().Now();
+		if (now < next->Time)
+		{
+			// Woken early when a schedule is added, replaced or cancelled, the earliest one is looked up again
+			Changed.wait_until(lock, next->Time);
+			continue;
+		}
+		if (next->Ready && !next->Ready())
+		{
+			next->Time = now + PollInterval;
+			continue;
+		}
+		// Scheduled with the lock held, so that a node is never scheduled after Cancel returned
+		nosScheduleNodeParams params = {};
+		params.NodeId = next->NodeId;
+		params.Reset = false;
+		params.AddScheduleCount = 1;
+		Pending.erase(next);
+		nosEngine.ScheduleNode(&params);
+	}
+}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "FramePacer.h"
+
+#include <Nodos/PluginHelpers.hpp>
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nos::display
+{
+// Schedules nodes at a later time from a single timer thread shared by every node, so that a self-scheduling node with
+// nothing to do until a deadline does not block its runner thread waiting for it.
+class ScheduleTimer
+{
+public:
+	using TimePoint = PacingClock::TimePoint;
+
+	static constexpr std::chrono::microseconds PollInterval{ 250 };
+
+	static std::shared_ptr<ScheduleTimer> Acquire();
+	~ScheduleTimer();
+
+	// Schedules the node once at time, right away if it has passed. A node has at most one pending schedule, a new one
+	// replaces it.
+	void ScheduleNodeAt(nosUUID nodeId, TimePoint time);
+	// Schedules the node once ready returns true. ready is polled on the timer thread every PollInterval, it must not block.
+	void ScheduleNodeWhen(nosUUID nodeId, std::function<bool()> ready);
+	// Once this returns, the node is not scheduled by the timer until ScheduleNodeAt is called again
+	void Cancel(nosUUID nodeId);
+
+private:
+	ScheduleTimer();
+	void Run();
+	void Add(nosUUID nodeId, TimePoint time, std::function<bool()> ready);
+
+	struct PendingSchedule
+	{
+		nosUUID NodeId;
+		TimePoint Time;
+		std::function<bool()> Ready;
+	};
+
+	std::thread Thread;
+	std::mutex Mutex;
+	std::condition_variable Changed;
+	bool StopRequested = false;
+	std::vector<PendingSchedule> Pending;
+};
+}
@@ -0,0 +1,230 @@
+#include "TimingCache.h"
+
+#include <Nodos/PluginHelpers.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace nos::display
+{
+namespace
+{
+// Bumped whenever the line layout changes, files of other versions are ignored
+constexpr std::string_view Header = "nosDisplay timing cache 1";
+constexpr size_t MaxTimingsPerDisplay = 16;
+
+void WriteTiming(std::ostream& stream, CachedTiming const& cached)
+{
+	auto& request = cached.Request;
+	auto& timing = cached.Timing;
+	char refreshRate[32];
+	std::snprintf(refreshRate, sizeof(refreshRate), "%.9g", request.RefreshRate);
+	stream << request.Width << ' ' << request.Height << ' ' << refreshRate << ' ' << uint32_t(request.Standard) << ' ' << uint32_t(request.Link) << ' '
+		   << request.ColorDepth << ' ' << timing.HActive << ' ' << timing.HFrontPorch << ' ' << timing.HSync << ' ' << timing.HBackPorch << ' '
+		   << timing.VActive << ' ' << timing.VFrontPorch << ' ' << timing.VSync << ' ' << timing.VBackPorch << ' ' << timing.PixelClock << ' '
+		   << timing.HSyncPositive << ' ' << timing.VSyncPositive;
+}
+
+std::optional<CachedTiming> ReadTiming(std::istream& stream)
+{
+	CachedTiming cached;
+	auto& request = cached.Request;
+	auto& timing = cached.Timing;
+	uint32_t standard, link;
+	stream >> request.Width >> request.Height >> request.RefreshRate >> standard >> link >> request.ColorDepth >> timing.HActive >> timing.HFrontPorch >>
+		timing.HSync >> timing.HBackPorch >> timing.VActive >> timing.VFrontPorch >> timing.VSync >> timing.VBackPorch >> timing.PixelClock >>
+		timing.HSyncPositive >> timing.VSyncPositive;
+	if (!stream || standard >= std::size(TimingStandardNames) || link >= std::size(DisplayLinkNames))
+		return std::nullopt;
+	request.Standard = TimingStandard(standard);
+	request.Link = DisplayLink(link);
+	return cached;
+}
+}
+
+std::filesystem::path TimingCache::GetDefaultPath()
+{
+	std::filesystem::path base;
+#if defined(WIN32)
+	if (auto localAppData = std::getenv("LOCALAPPDATA"))
+		base = localAppData;
+#else
+	if (auto cacheHome = std::getenv("XDG_CACHE_HOME"); cacheHome && *cacheHome)
+		base = cacheHome;
+	else if (auto home = std::getenv("HOME"))
+		base = std::filesystem::path(home) / ".cache";
+#endif
+	if (base.empty())
+		return {};
+	return base / "nosDisplay" / "TimingCache.txt";
+}
+
+void TimingCache::Load(std::filesystem::path path)
+{
+	std::unique_lock lock(Mutex);
+	Path = std::move(path);
+	Displays.clear();
+	if (Path.empty())
+		return;
+	std::ifstream file(Path);
+	if (file)
+		Parse(file);
+}
+
+void TimingCache::Parse(std::istream& stream)
+{
+	std::string line;
+	if (!std::getline(stream, line) || line != Header)
+		return;
+	while (std::getline(stream, line))
+	{
+		std::istringstream fields(line);
+		std::string type;
+		MonitorKey key;
+		fields >> type >> key.GPUBusId >> key.PortId;
+		if (!fields)
+			continue;
+		if (type == "display")
+		{
+			Display display;
+			fields >> std::hex >> display.EDIDHash >> std::dec;
+			if (!fields)
+				continue;
+			std::getline(fields >> std::ws, display.MonitorName);
+			Displays[key] = std::move(display);
+			continue;
+		}
+		// Timings follow the display they belong to
+		auto it = Displays.find(key);
+		if (it == Displays.end())
+			continue;
+		auto cached = ReadTiming(fields);
+		if (!cached)
+			continue;
+		if (type == "timing")
+			it->second.Timings.push_back(*cached);
+		else if (type == "applied")
+			it->second.Applied = *cached;
+	}
+}
+
+void TimingCache::Save() const
+{
+	if (Path.empty())
+		return;
+	std::ostringstream stream;
+	stream << Header << '\n';
+	for (auto& [key, display] : Displays)
+	{
+		char hash[17];
+		std::snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)display.EDIDHash);
+		stream << "display " << key.GPUBusId << ' ' << key.PortId << ' ' << hash << ' ' << display.MonitorName << '\n';
+		for (auto& timing : display.Timings)
+		{
+			stream << "timing " << key.GPUBusId << ' ' << key.PortId << ' ';
+			WriteTiming(stream, timing);
+			stream << '\n';
+		}
+		if (display.Applied)
+		{
+			stream << "applied " << key.GPUBusId << ' ' << key.PortId << ' ';
+			WriteTiming(stream, *display.Applied);
+			stream << '\n';
+		}
+	}
+	// Written next to the file and moved over it, a crash never leaves a half written cache
+	std::error_code error;
+	std::filesystem::create_directories(Path.parent_path(), error);
+	auto temporaryPath = Path;
+	temporaryPath += ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::trunc);
+		if (!(file << stream.str()))
+		{
+			nosEngine.LogW("Failed to write the timing cache to %s", temporaryPath.string().c_str());
+			return;
+		}
+	}
+	std::filesystem::rename(temporaryPath, Path, error);
+	if (error)
+		nosEngine.LogW("Failed to write the timing cache to %s: %s", Path.string().c_str(), error.message().c_str());
+}
+
+bool TimingCache::UpdateDisplay(MonitorKey key, uint64_t edidHash, std::string_view monitorName)
+{
+	std::unique_lock lock(Mutex);
+	auto [it, inserted] = Displays.try_emplace(key);
+	auto& display = it->second;
+	if (!inserted && display.EDIDHash == edidHash)
+		return true;
+	bool replaced = !inserted;
+	display = { .EDIDHash = edidHash, .MonitorName = std::string(monitorName) };
+	Save();
+	return !replaced;
+}
+
+std::optional<DisplayTiming> TimingCache::FindTiming(MonitorKey key, uint64_t edidHash, TimingRequest const& request) const
+{
+	std::unique_lock lock(Mutex);
+	auto it = Displays.find(key);
+	if (it == Displays.end() || it->second.EDIDHash != edidHash)
+		return std::nullopt;
+	for (auto& cached : it->second.Timings)
+		if (cached.Request == request)
+			return cached.Timing;
+	return std::nullopt;
+}
+
+void TimingCache::AddTiming(MonitorKey key, uint64_t edidHash, TimingRequest const& request, DisplayTiming const& timing)
+{
+	std::unique_lock lock(Mutex);
+	auto it = Displays.find(key);
+	if (it == Displays.end() || it->second.EDIDHash != edidHash)
+		return;
+	auto& timings = it->second.Timings;
+	std::erase_if(timings, [&](CachedTiming const& cached) { return cached.Request == request; });
+	if (timings.size() >= MaxTimingsPerDisplay)
+		timings.erase(timings.begin());
+	timings.push_back({ .Request = request, .Timing = timing });
+	Save();
+}
+
+std::optional<CachedTiming> TimingCache::FindAppliedMode(MonitorKey key, uint64_t edidHash) const
+{
+	std::unique_lock lock(Mutex);
+	auto it = Displays.find(key);
+	if (it == Displays.end() || it->second.EDIDHash != edidHash)
+		return std::nullopt;
+	return it->second.Applied;
+}
+
+void TimingCache::SetAppliedMode(MonitorKey key, uint64_t edidHash, TimingRequest const& request, DisplayTiming const& timing)
+{
+	std::unique_lock lock(Mutex);
+	auto it = Displays.find(key);
+	if (it == Displays.end() || it->second.EDIDHash != edidHash)
+		return;
+	it->second.Applied = CachedTiming{ .Request = request, .Timing = timing };
+	Save();
+}
+
+void TimingCache::ClearAppliedMode(MonitorKey key)
+{
+	std::unique_lock lock(Mutex);
+	auto it = Displays.find(key);
+	if (it == Displays.end() || !it->second.Applied)
+		return;
+	it->second.Applied.reset();
+	Save();
+}
+
+uint64_t HashEDID(std::span<const uint8_t> edid)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (uint8_t byte : edid)
+		hash = (hash ^ byte) * 0x100000001b3ull;
+	return hash;
+}
+}
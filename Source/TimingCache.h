@@ -0,0 +1,74 @@
+#pragma once
+
+#include "DisplayTiming.h"
+#include "MonitorKey.h"
+
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nos::display
+{
+// What a custom mode is resolved from. The same request on the same display and port always resolves to the same timing.
+struct TimingRequest
+{
+	uint32_t Width = 0, Height = 0;
+	float RefreshRate = 0;
+	TimingStandard Standard = TimingStandard::Auto;
+	DisplayLink Link = DisplayLink::Unknown;
+	uint32_t ColorDepth = 32;
+	bool operator==(const TimingRequest&) const = default;
+};
+
+struct CachedTiming
+{
+	TimingRequest Request;
+	DisplayTiming Timing;
+};
+
+// Timings resolved in earlier runs, the modes left applied on displays and which display was last seen on each port.
+// Kept on disk so that a restart neither resolves timings again nor switches a display that already runs its mode.
+// Entries are keyed by port and the hash of the display's EDID, a different display on a port drops the entries of
+// the previous one. Thread safe.
+struct TimingCache
+{
+	// LOCALAPPDATA on Windows, XDG_CACHE_HOME (or ~/.cache) elsewhere. Empty if neither is known.
+	static std::filesystem::path GetDefaultPath();
+
+	// Reads the file at path, changes are written back to it. The cache stays in memory only if path is empty.
+	void Load(std::filesystem::path path);
+
+	// Records the display now on key. Returns false, and drops everything cached for key, if another display was seen there before.
+	bool UpdateDisplay(MonitorKey key, uint64_t edidHash, std::string_view monitorName);
+
+	std::optional<DisplayTiming> FindTiming(MonitorKey key, uint64_t edidHash, TimingRequest const& request) const;
+	void AddTiming(MonitorKey key, uint64_t edidHash, TimingRequest const& request, DisplayTiming const& timing);
+
+	// Mode left on the display by the last successful apply, until it is reverted
+	std::optional<CachedTiming> FindAppliedMode(MonitorKey key, uint64_t edidHash) const;
+	void SetAppliedMode(MonitorKey key, uint64_t edidHash, TimingRequest const& request, DisplayTiming const& timing);
+	void ClearAppliedMode(MonitorKey key);
+
+private:
+	struct Display
+	{
+		uint64_t EDIDHash = 0;
+		std::string MonitorName;
+		std::vector<CachedTiming> Timings; // Oldest first
+		std::optional<CachedTiming> Applied;
+	};
+
+	void Parse(std::istream& stream);
+	void Save() const;
+
+	mutable std::mutex Mutex;
+	std::filesystem::path Path;
+	std::unordered_map<MonitorKey, Display, MonitorKeyHash> Displays;
+};
+
+// FNV-1a of the raw EDID, identifies a display model and unit
+uint64_t HashEDID(std::span<const uint8_t> edid);
+}
@@ -0,0 +1,37 @@
+#include "VideoWall.h"
+
+#include <algorithm>
+
+namespace nos::display
+{
+std::vector<PresentRect> ComputeWallLayout(std::vector<WallTile> const& tiles, uint32_t columns, nosVec2u bezel)
+{
+	columns = std::max(columns, 1u);
+	size_t rows = (tiles.size() + columns - 1) / columns;
+	std::vector<uint32_t> columnWidths(columns), rowHeights(rows);
+	for (size_t i = 0; i < tiles.size(); ++i)
+	{
+		auto extent = GetRotatedExtent(tiles[i].Extent, tiles[i].Rotation);
+		columnWidths[i % columns] = std::max(columnWidths[i % columns], extent.x);
+		rowHeights[i / columns] = std::max(rowHeights[i / columns], extent.y);
+	}
+	std::vector<PresentRect> rects(tiles.size());
+	float y = 0;
+	for (size_t row = 0; row < rows; ++row)
+	{
+		float x = 0;
+		for (size_t column = 0; column < columns; ++column)
+		{
+			size_t i = row * columns + column;
+			if (i < tiles.size())
+			{
+				auto extent = GetRotatedExtent(tiles[i].Extent, tiles[i].Rotation);
+				rects[i] = { x + tiles[i].Offset.x, y + tiles[i].Offset.y, float(extent.x), float(extent.y) };
+			}
+			x += columnWidths[column] + bezel.x;
+		}
+		y += rowHeights[row] + bezel.y;
+	}
+	return rects;
+}
+}
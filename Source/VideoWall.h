@@ -0,0 +1,21 @@
+#pragma once
+
+#include "PresentPass.h"
+
+#include <vector>
+
+namespace nos::display
+{
+// One monitor of a video wall
+struct WallTile
+{
+	nosVec2u Extent{}; // Monitor resolution
+	nosVec2i Offset{}; // Extra shift of the tile on the canvas, in canvas pixels
+	PresentRotation Rotation = PresentRotation::None;
+};
+
+// Places the tiles on a canvas row by row, columns tiles per row. Columns are as wide and rows as tall as their largest
+// (rotated) tile, and bezel canvas pixels are skipped between neighbouring tiles so that content lines up across the
+// physical gaps. Returns the canvas rect each tile shows, in canvas pixels.
+std::vector<PresentRect> ComputeWallLayout(std::vector<WallTile> const& tiles, uint32_t columns, nosVec2u bezel);
+}
@@ -0,0 +1,197 @@
+#include "WindowRuntime.h"
+#include "CustomResolutionBase.h"
+
+#include "nosUtil/Stopwatch.hpp"
+#include "GLFW/glfw3.h"
+#if defined(WIN32)
+#define GLFW_EXPOSE_NATIVE_WIN32
+#elif defined(__linux)
+#define GLFW_EXPOSE_NATIVE_X11
+#else
+#error "Unsupported platform"
+#endif
+#include "GLFW/glfw3native.h"
+
+namespace nos::display
+{
+namespace
+{
+std::mutex RuntimeMutex;
+std::weak_ptr<WindowRuntime> RuntimeInstance;
+// Held by the event thread from glfwInit to glfwTerminate, so a new runtime cannot initialize GLFW while the previous
+// one is still terminating it.
+std::mutex GLFWLifetimeMutex;
+// Only accessed on the event thread
+WindowRuntime* EventThreadRuntime = nullptr;
+
+const char* GetMonitorAdapterName(GLFWmonitor* monitor)
+{
+#if defined(WIN32)
+	return glfwGetWin32Adapter(monitor);
+#else
+	// GLFW names X11 monitors after their RandR output
+	return glfwGetMonitorName(monitor);
+#endif
+}
+
+std::vector<WindowSystemMonitor> GetWindowSystemMonitors()
+{
+	std::vector<WindowSystemMonitor> result;
+	int monitorCount;
+	GLFWmonitor** monitors = glfwGetMonitors(&monitorCount);
+	for (int i = 0; i < monitorCount; i++)
+		result.push_back({ .AdapterName = GetMonitorAdapterName(monitors[i]), .Handle = monitors[i], .Name = glfwGetMonitorName(monitors[i]) });
+	return result;
+}
+
+WindowEventQueue* GetQueue(GLFWwindow* window)
+{
+	return (WindowEventQueue*)glfwGetWindowUserPointer(window);
+}
+}
+
+std::shared_ptr<WindowRuntime> WindowRuntime::Acquire()
+{
+	std::unique_lock lock(RuntimeMutex);
+	auto runtime = RuntimeInstance.lock();
+	if (!runtime)
+	{
+		runtime = std::shared_ptr<WindowRuntime>(new WindowRuntime());
+		if (!runtime->Initialized)
+			return nullptr;
+		RuntimeInstance = runtime;
+	}
+	return runtime;
+}
+
+WindowRuntime::WindowRuntime()
+{
+	std::promise<void> started;
+	auto startedFuture = started.get_future();
+	Thread = std::thread([this, &started] { Run(started); });
+	startedFuture.wait();
+}
+
+WindowRuntime::~WindowRuntime()
+{
+	StopRequested = true;
+	if (Initialized)
+		glfwPostEmptyEvent();
+	Thread.join();
+}
+
+void WindowRuntime::Run(std::promise<void>& started)
+{
+	std::unique_lock lifetimeLock(GLFWLifetimeMutex);
+	EventThreadRuntime = this;
+	glfwSetErrorCallback([](int error, const char* description) { nosEngine.LogE("GLFW error %d: %s", error, description); });
+	if (!glfwInit())
+	{
+		nosEngine.LogE("Failed to initialize GLFW");
+		EventThreadRuntime = nullptr;
+		started.set_value();
+		return;
+	}
+	glfwSetMonitorCallback([](GLFWmonitor*, int) { EventThreadRuntime->RefreshMonitorsOnEventThread(); });
+	RefreshMonitorsOnEventThread();
+	Initialized = true;
+	started.set_value();
+	while (!StopRequested)
+	{
+		glfwWaitEvents();
+		RunTasks();
+	}
+	RunTasks();
+	glfwTerminate();
+	EventThreadRuntime = nullptr;
+}
+
+void WindowRuntime::RunTasks()
+{
+	std::vector<std::function<void()>> tasks;
+	{
+		std::unique_lock lock(TasksMutex);
+		tasks.swap(Tasks);
+	}
+	for (auto& task : tasks)
+		task();
+}
+
+void WindowRuntime::Post(std::function<void()> task)
+{
+	{
+		std::unique_lock lock(TasksMutex);
+		Tasks.push_back(std::move(task));
+	}
+	glfwPostEmptyEvent();
+}
+
+GLFWwindow* WindowRuntime::OpenWindow(WindowGeometry const& geometry, std::string const& title, WindowEventQueue* events)
+{
+	return Invoke([&]() -> GLFWwindow* {
+		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		glfwWindowHint(GLFW_DECORATED, geometry.Decorated ? GLFW_TRUE : GLFW_FALSE);
+		GLFWwindow* window = glfwCreateWindow(geometry.Size.x, geometry.Size.y, title.c_str(), nullptr, nullptr);
+		glfwDefaultWindowHints();
+		if (!window)
+			return nullptr;
+		if (geometry.Position)
+			glfwSetWindowPos(window, geometry.Position->x, geometry.Position->y);
+		glfwShowWindow(window);
+		glfwSetWindowUserPointer(window, events);
+		glfwSetWindowSizeCallback(window, [](GLFWwindow* window, int width, int height) {
+			GetQueue(window)->Push({ WindowEventType::Resized, width, height });
+		});
+		glfwSetWindowPosCallback(window, [](GLFWwindow* window, int posx, int posy) {
+			GetQueue(window)->Push({ WindowEventType::Moved, posx, posy });
+		});
+		glfwSetWindowIconifyCallback(window, [](GLFWwindow* window, int iconified) {
+			auto queue = GetQueue(window);
+			if (iconified == GLFW_TRUE && queue->Locked)
+				glfwRestoreWindow(window);
+			queue->Push({ iconified == GLFW_TRUE ? WindowEventType::Iconified : WindowEventType::Restored });
+		});
+		glfwSetWindowFocusCallback(window, [](GLFWwindow* window, int focused) {
+			GetQueue(window)->Push({ focused == GLFW_TRUE ? WindowEventType::FocusGained : WindowEventType::FocusLost });
+		});
+		glfwSetWindowCloseCallback(window, [](GLFWwindow* window) {
+			auto queue = GetQueue(window);
+			if (queue->Locked)
+			{
+				glfwSetWindowShouldClose(window, GLFW_FALSE);
+				return;
+			}
+			queue->Push({ WindowEventType::CloseRequested });
+		});
+		Queues.push_back(events);
+		return window;
+	});
+}
+
+void WindowRuntime::ReleaseWindow(GLFWwindow* window)
+{
+	Invoke([&] {
+		std::erase(Queues, GetQueue(window));
+		glfwDestroyWindow(window);
+	});
+}
+
+void WindowRuntime::RefreshMonitors()
+{
+	Invoke([this] { RefreshMonitorsOnEventThread(); });
+}
+
+void WindowRuntime::RefreshMonitorsOnEventThread()
+{
+	auto customRes = CustomResolutionBase::Get();
+	if (!customRes)
+		return;
+	util::Stopwatch enumerationWatch;
+	customRes->RefreshTopology(GetWindowSystemMonitors());
+	LastMonitorEnumerationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(enumerationWatch.Elapsed()).count();
+	for (auto queue : Queues)
+		queue->Push({ WindowEventType::MonitorsChanged });
+}
+}
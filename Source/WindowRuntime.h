@@ -0,0 +1,127 @@
+#pragma once
+
+#include <Nodos/PluginHelpers.hpp>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+struct GLFWwindow;
+
+namespace nos::display
+{
+enum class WindowEventType : uint8_t
+{
+	Resized,
+	Moved,
+	Iconified,
+	Restored,
+	FocusGained,
+	FocusLost,
+	CloseRequested,
+	MonitorsChanged,
+};
+
+struct WindowEvent
+{
+	WindowEventType Type;
+	int X = 0;
+	int Y = 0;
+};
+
+struct WindowGeometry
+{
+	std::optional<nosVec2i> Position; // Left to the window system if not set
+	nosVec2u Size;
+	bool Decorated = true;
+};
+
+// Lock-free single producer (the window event thread), single consumer (the node's runner thread) queue.
+struct WindowEventQueue
+{
+	static constexpr size_t Capacity = 64;
+
+	bool Push(WindowEvent const& event)
+	{
+		size_t tail = Tail.load(std::memory_order_relaxed);
+		if (tail - Head.load(std::memory_order_acquire) == Capacity)
+		{
+			Dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		Events[tail % Capacity] = event;
+		Tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool Pop(WindowEvent& out)
+	{
+		size_t head = Head.load(std::memory_order_relaxed);
+		if (head == Tail.load(std::memory_order_acquire))
+			return false;
+		out = Events[head % Capacity];
+		Head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Read by the event thread, so that closing and minimizing a locked window can be refused synchronously
+	std::atomic<bool> Locked = false;
+	std::atomic<uint64_t> Dropped = 0;
+
+private:
+	std::array<WindowEvent, Capacity> Events{};
+	alignas(64) std::atomic<size_t> Head = 0;
+	alignas(64) std::atomic<size_t> Tail = 0;
+};
+
+// Process-wide GLFW state shared by every DisplayOut. GLFW is initialized with the first reference and terminated with
+// the last one. All windows are created, pumped and destroyed on a single event thread, nodes receive their window's
+// events through a WindowEventQueue and send window changes with Post.
+class WindowRuntime
+{
+public:
+	// Null if GLFW could not be initialized
+	static std::shared_ptr<WindowRuntime> Acquire();
+	~WindowRuntime();
+
+	// The window is created hidden and only shown once it is at its final geometry
+	GLFWwindow* OpenWindow(WindowGeometry const& geometry, std::string const& title, WindowEventQueue* events);
+	void ReleaseWindow(GLFWwindow* window);
+
+	// Runs a task on the event thread without waiting for it
+	void Post(std::function<void()> task);
+	// Runs a task on the event thread and waits for its result
+	template <typename F>
+	auto Invoke(F&& task) -> decltype(task())
+	{
+		if (std::this_thread::get_id() == Thread.get_id())
+			return task();
+		std::packaged_task<decltype(task())()> packaged(std::forward<F>(task));
+		auto result = packaged.get_future();
+		Post([&packaged] { packaged(); });
+		return result.get();
+	}
+
+	// Rebuilds the display topology on the event thread and notifies every window
+	void RefreshMonitors();
+	std::chrono::nanoseconds GetLastMonitorEnumerationTime() const { return std::chrono::nanoseconds(LastMonitorEnumerationNs.load()); }
+
+private:
+	WindowRuntime();
+	void Run(std::promise<void>& started);
+	void RunTasks();
+	void RefreshMonitorsOnEventThread();
+
+	std::thread Thread;
+	bool Initialized = false;
+	std::atomic<bool> StopRequested = false;
+	std::mutex TasksMutex;
+	std::vector<std::function<void()>> Tasks;
+	std::vector<WindowEventQueue*> Queues; // Only touched on the event thread
+	std::atomic<int64_t> LastMonitorEnumerationNs = 0;
+};
+}
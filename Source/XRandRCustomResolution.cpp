@@ -0,0 +1,584 @@
+#if defined(__linux)
+#include "CustomResolutionBase.h"
+#include "DisplayTiming.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_set>
+#include <utility>
+
+#include <xcb/xcb.h>
+#include <xcb/randr.h>
+
+namespace nos::display
+{
+namespace
+{
+struct FreeReply
+{
+	void operator()(void* reply) const { std::free(reply); }
+};
+template <typename T>
+using XcbReply = std::unique_ptr<T, FreeReply>;
+using ScreenResources = xcb_randr_get_screen_resources_current_reply_t;
+using OutputInfo = xcb_randr_get_output_info_reply_t;
+using CrtcInfo = xcb_randr_get_crtc_info_reply_t;
+
+// Errors come back with the reply, or from xcb_request_check for requests without one. Nothing goes through Xlib's
+// process wide error handler, which GLFW swaps on its own thread.
+std::optional<std::string> TakeError(xcb_generic_error_t* error)
+{
+	if (!error)
+		return std::nullopt;
+	char text[64];
+	std::snprintf(text, sizeof(text), "X error %u on request %u.%u", error->error_code, error->major_code, error->minor_code);
+	std::free(error);
+	return text;
+}
+
+DisplayTiming FromModeInfo(xcb_randr_mode_info_t const& mode)
+{
+	DisplayTiming timing;
+	timing.HActive = mode.width;
+	timing.HFrontPorch = mode.hsync_start - mode.width;
+	timing.HSync = mode.hsync_end - mode.hsync_start;
+	timing.HBackPorch = mode.htotal - mode.hsync_end;
+	timing.VActive = mode.height;
+	timing.VFrontPorch = mode.vsync_start - mode.height;
+	timing.VSync = mode.vsync_end - mode.vsync_start;
+	timing.VBackPorch = mode.vtotal - mode.vsync_end;
+	timing.PixelClock = mode.dot_clock;
+	timing.HSyncPositive = mode.mode_flags & XCB_RANDR_MODE_FLAG_HSYNC_POSITIVE;
+	timing.VSyncPositive = mode.mode_flags & XCB_RANDR_MODE_FLAG_VSYNC_POSITIVE;
+	return timing;
+}
+
+std::string GetOutputName(OutputInfo* info)
+{
+	return std::string((const char*)xcb_randr_get_output_info_name(info), xcb_randr_get_output_info_name_length(info));
+}
+}
+
+// Custom modes through the X Resize and Rotate extension. Modes are created from computed timings and set on the CRTC
+// driving the output, growing the screen when the new mode does not fit. Color depth and format
+// are those of the X screen and cannot be changed per output.
+// GPUs are RandR providers (a single unnamed GPU when the server has none, e.g. Xvfb), ports are output indices of
+// their provider.
+// Talks to the server over its own XCB connection, separate from the one of GLFW.
+struct XRandRCustomResolution : CustomResolutionBase
+{
+	bool Init() override
+	{
+		std::unique_lock lock(Mutex);
+		int screenIndex = 0;
+		Connection = xcb_connect(nullptr, &screenIndex);
+		if (xcb_connection_has_error(Connection))
+		{
+			nosEngine.LogE("Failed to open X display, custom resolutions need an X server");
+			xcb_disconnect(std::exchange(Connection, nullptr));
+			return false;
+		}
+		auto extension = xcb_get_extension_data(Connection, &xcb_randr_id);
+		XcbReply<xcb_randr_query_version_reply_t> version(
+			extension && extension->present ? xcb_randr_query_version_reply(Connection, xcb_randr_query_version(Connection, 1, 4), nullptr) : nullptr);
+		if (!version || version->major_version < 1 || (version->major_version == 1 && version->minor_version < 2))
+		{
+			nosEngine.LogE("X server does not support RandR 1.2, which is required for custom resolutions");
+			xcb_disconnect(std::exchange(Connection, nullptr));
+			return false;
+		}
+		HasProviders = version->major_version > 1 || version->minor_version >= 4;
+		auto screens = xcb_setup_roots_iterator(xcb_get_setup(Connection));
+		for (; screenIndex > 0 && screens.rem; --screenIndex)
+			xcb_screen_next(&screens);
+		Screen = screens.data;
+		Root = Screen->root;
+		return true;
+	}
+
+	void Shutdown() override
+	{
+		std::unique_lock lock(Mutex);
+		if (!Connection)
+			return;
+		for (auto& [port, applied] : Applied)
+			Restore(applied);
+		Applied.clear();
+		xcb_disconnect(std::exchange(Connection, nullptr));
+	}
+
+protected:
+	// RandR 1.2 sets one CRTC per request, the server is grabbed so that other clients see a single change
+	bool ApplyModes(std::vector<CustomResolutionRequest> const& requests) override
+	{
+		// There is no driver to ask, Auto takes the reduced blanking v2 timing unless the EDID says otherwise.
+		// Resolved before locking, reading the EDID locks too.
+		std::vector<DisplayTiming> timings;
+		for (auto& request : requests)
+		{
+			auto timing = ResolveTiming(request.Port, request.Info);
+			if (!timing)
+				return false;
+			timings.push_back(*timing);
+		}
+		std::unique_lock lock(Mutex);
+		if (!Connection)
+			return false;
+		xcb_grab_server(Connection);
+		bool applied = true;
+		for (size_t i = 0; i < requests.size() && applied; ++i)
+			applied = ApplyMode(requests[i].Port, timings[i], lock);
+		xcb_ungrab_server(Connection);
+		xcb_flush(Connection);
+		return applied;
+	}
+
+	bool RevertModes(std::vector<GPUPortIdentifier> const& portIds) override
+	{
+		std::unique_lock lock(Mutex);
+		if (!Connection)
+			return false;
+		xcb_grab_server(Connection);
+		bool reverted = true;
+		for (auto& portId : portIds)
+			reverted &= RevertResolution(portId, lock);
+		xcb_ungrab_server(Connection);
+		xcb_flush(Connection);
+		return reverted;
+	}
+
+private:
+	bool ApplyMode(GPUPortIdentifier portId, DisplayTiming const& timing, std::unique_lock<std::mutex>& lock)
+	{
+		auto output = GetOutput(portId);
+		if (!output)
+		{
+			nosEngine.LogE("Output not found for port %u", portId.PortId);
+			return false;
+		}
+
+		auto resources = GetScreenResources();
+		auto outputInfo = resources ? GetOutputInfo(resources.get(), *output) : nullptr;
+		if (!outputInfo || !outputInfo->crtc)
+		{
+			nosEngine.LogE("Output %u is not driven by a CRTC", portId.PortId);
+			return false;
+		}
+		auto outputName = GetOutputName(outputInfo.get());
+		auto crtcInfo = GetCrtcInfo(resources.get(), outputInfo->crtc);
+		if (!crtcInfo)
+			return false;
+		auto crtcOutputs = xcb_randr_get_crtc_info_outputs(crtcInfo.get());
+
+		// The first original is kept so that repeated changes still revert to the mode the output started with
+		auto it = Applied.find(portId);
+		if (it == Applied.end())
+		{
+			AppliedMode applied{
+				.Output = *output,
+				.Crtc = outputInfo->crtc,
+				.OriginalMode = crtcInfo->mode,
+				.OriginalRotation = crtcInfo->rotation,
+				.X = crtcInfo->x,
+				.Y = crtcInfo->y,
+				.Outputs = { crtcOutputs, crtcOutputs + xcb_randr_get_crtc_info_outputs_length(crtcInfo.get()) },
+				.ScreenSize = GetScreenSize(),
+			};
+			it = Applied.emplace(portId, std::move(applied)).first;
+		}
+		auto& applied = it->second;
+
+		auto mode = FindOrCreateMode(resources.get(), timing);
+		if (!mode)
+			return false;
+		if (auto error = TakeError(xcb_request_check(Connection, xcb_randr_add_output_mode_checked(Connection, *output, *mode))))
+		{
+			nosEngine.LogE("Failed to add mode to output %s: %s", outputName.c_str(), error->c_str());
+			return false;
+		}
+
+		if (!FitScreen(resources.get(), outputInfo->crtc, timing, crtcInfo->rotation) ||
+			!SetCrtcMode(resources.get(), outputName, outputInfo->crtc, crtcInfo.get(), *mode))
+		{
+			if (*mode != applied.Mode)
+				ForgetMode(applied.Output, *mode);
+			RevertResolution(portId, lock);
+			return false;
+		}
+		// The server refuses to delete a mode a CRTC still scans out, the previous one goes once it is replaced
+		if (applied.Mode && applied.Mode != *mode)
+			ForgetMode(applied.Output, applied.Mode);
+		applied.Mode = *mode;
+		return true;
+	}
+
+protected:
+	std::optional<DisplayTiming> GetCurrentTiming(GPUPortIdentifier portId) override
+	{
+		std::unique_lock lock(Mutex);
+		auto output = GetOutput(portId);
+		if (!output)
+			return std::nullopt;
+		auto resources = GetScreenResources();
+		auto outputInfo = resources ? GetOutputInfo(resources.get(), *output) : nullptr;
+		if (!outputInfo || !outputInfo->crtc)
+			return std::nullopt;
+		auto crtcInfo = GetCrtcInfo(resources.get(), outputInfo->crtc);
+		if (!crtcInfo || !crtcInfo->mode)
+			return std::nullopt;
+		auto modes = xcb_randr_get_screen_resources_current_modes(resources.get());
+		for (int i = 0; i < xcb_randr_get_screen_resources_current_modes_length(resources.get()); ++i)
+			if (modes[i].id == crtcInfo->mode)
+				return FromModeInfo(modes[i]);
+		return std::nullopt;
+	}
+
+	std::optional<std::vector<uint8_t>> ReadEDID(GPUPortIdentifier portId) override
+	{
+		std::unique_lock lock(Mutex);
+		auto output = GetOutput(portId);
+		if (!output)
+			return std::nullopt;
+		constexpr std::string_view EDIDName = "EDID";
+		XcbReply<xcb_intern_atom_reply_t> edidAtom(
+			xcb_intern_atom_reply(Connection, xcb_intern_atom(Connection, 1, uint16_t(EDIDName.size()), EDIDName.data()), nullptr));
+		if (!edidAtom || edidAtom->atom == XCB_ATOM_NONE)
+			return std::nullopt;
+		// EDIDs with their extensions stay well below 32 KiB, the length is in 32 bit units
+		XcbReply<xcb_randr_get_output_property_reply_t> property(xcb_randr_get_output_property_reply(
+			Connection, xcb_randr_get_output_property(Connection, *output, edidAtom->atom, XCB_ATOM_ANY, 0, 8192, 0, 0), nullptr));
+		if (!property || property->format != 8 || !property->num_items)
+			return std::nullopt;
+		auto data = xcb_randr_get_output_property_data(property.get());
+		return std::vector<uint8_t>(data, data + xcb_randr_get_output_property_data_length(property.get()));
+	}
+
+	std::optional<uint32_t> GetDisplayIdFromAdapterName(const char* adapterName) override
+	{
+		// GLFW names X11 monitors after their RandR output
+		std::unique_lock lock(Mutex);
+		if (!Connection)
+			return std::nullopt;
+		auto resources = GetScreenResources();
+		if (!resources)
+			return std::nullopt;
+		auto outputs = xcb_randr_get_screen_resources_current_outputs(resources.get());
+		for (int i = 0; i < xcb_randr_get_screen_resources_current_outputs_length(resources.get()); ++i)
+		{
+			auto info = GetOutputInfo(resources.get(), outputs[i]);
+			if (info && GetOutputName(info.get()) == adapterName)
+				return uint32_t(outputs[i]);
+		}
+		return std::nullopt;
+	}
+
+	std::optional<GPUPortIdentifier> GetPortFromDisplayId(uint32_t displayId) override
+	{
+		std::unique_lock lock(Mutex);
+		for (auto& display : EnumerateOutputs(false))
+			if (display.DisplayId == displayId)
+				return display.Port;
+		return std::nullopt;
+	}
+
+	std::optional<uint32_t> GetGPUBusId(void* gpuId) override
+	{
+		// RandR does not expose the PCI bus, the provider index is stable for a given set of GPUs
+		std::unique_lock lock(Mutex);
+		auto providers = GetProviders();
+		for (uint32_t i = 0; i < providers.size(); ++i)
+			if ((void*)uintptr_t(providers[i]) == gpuId)
+				return i;
+		return gpuId ? std::nullopt : std::optional<uint32_t>(0);
+	}
+
+	std::vector<DisplayPortInfo> EnumerateActiveDisplays() override
+	{
+		std::unique_lock lock(Mutex);
+		return EnumerateOutputs(true);
+	}
+
+private:
+	struct AppliedMode
+	{
+		xcb_randr_output_t Output = 0;
+		xcb_randr_crtc_t Crtc = 0;
+		xcb_randr_mode_t OriginalMode = 0;
+		uint16_t OriginalRotation = XCB_RANDR_ROTATION_ROTATE_0;
+		int16_t X = 0, Y = 0;
+		std::vector<xcb_randr_output_t> Outputs;
+		nosVec2u ScreenSize{};
+		xcb_randr_mode_t Mode = 0; // Mode set by us, 0 if none
+	};
+
+	XcbReply<ScreenResources> GetScreenResources()
+	{
+		return XcbReply<ScreenResources>(
+			xcb_randr_get_screen_resources_current_reply(Connection, xcb_randr_get_screen_resources_current(Connection, Root), nullptr));
+	}
+
+	XcbReply<OutputInfo> GetOutputInfo(ScreenResources* resources, xcb_randr_output_t output)
+	{
+		return XcbReply<OutputInfo>(
+			xcb_randr_get_output_info_reply(Connection, xcb_randr_get_output_info(Connection, output, resources->config_timestamp), nullptr));
+	}
+
+	XcbReply<CrtcInfo> GetCrtcInfo(ScreenResources* resources, xcb_randr_crtc_t crtc)
+	{
+		return XcbReply<CrtcInfo>(xcb_randr_get_crtc_info_reply(Connection, xcb_randr_get_crtc_info(Connection, crtc, resources->config_timestamp), nullptr));
+	}
+
+	// The setup block keeps the size the screen had when connecting, the root window follows it
+	nosVec2u GetScreenSize()
+	{
+		XcbReply<xcb_get_geometry_reply_t> geometry(xcb_get_geometry_reply(Connection, xcb_get_geometry(Connection, Root), nullptr));
+		if (!geometry)
+			return { Screen->width_in_pixels, Screen->height_in_pixels };
+		return { geometry->width, geometry->height };
+	}
+
+	// Physical size of a screen of the given pixel size, at the density the server reported when connecting
+	nosVec2u GetScreenSizeMM(nosVec2u size) const
+	{
+		return { uint32_t(uint64_t(Screen->width_in_millimeters) * size.x / std::max<uint16_t>(Screen->width_in_pixels, 1)),
+				 uint32_t(uint64_t(Screen->height_in_millimeters) * size.y / std::max<uint16_t>(Screen->height_in_pixels, 1)) };
+	}
+
+	std::vector<xcb_randr_provider_t> GetProviders()
+	{
+		std::vector<xcb_randr_provider_t> result;
+		if (!Connection || !HasProviders)
+			return result;
+		XcbReply<xcb_randr_get_providers_reply_t> providers(xcb_randr_get_providers_reply(Connection, xcb_randr_get_providers(Connection, Root), nullptr));
+		if (providers)
+		{
+			auto first = xcb_randr_get_providers_providers(providers.get());
+			result.assign(first, first + xcb_randr_get_providers_providers_length(providers.get()));
+		}
+		return result;
+	}
+
+	std::vector<DisplayPortInfo> EnumerateOutputs(bool activeOnly)
+	{
+		std::vector<DisplayPortInfo> result;
+		if (!Connection)
+			return result;
+		auto resources = GetScreenResources();
+		if (!resources)
+			return result;
+		auto addOutputs = [&](void* gpuId, xcb_randr_output_t const* outputs, int count) {
+			for (int i = 0; i < count; ++i)
+			{
+				if (activeOnly)
+				{
+					auto info = GetOutputInfo(resources.get(), outputs[i]);
+					if (!info || info->connection != XCB_RANDR_CONNECTION_CONNECTED || !info->crtc)
+						continue;
+				}
+				result.push_back({ .Port = { .GPUId = gpuId, .PortId = uint32_t(i) }, .DisplayId = uint32_t(outputs[i]) });
+			}
+		};
+		auto providers = GetProviders();
+		if (providers.empty())
+		{
+			addOutputs(nullptr, xcb_randr_get_screen_resources_current_outputs(resources.get()),
+					   xcb_randr_get_screen_resources_current_outputs_length(resources.get()));
+			return result;
+		}
+		for (auto provider : providers)
+		{
+			XcbReply<xcb_randr_get_provider_info_reply_t> info(xcb_randr_get_provider_info_reply(
+				Connection, xcb_randr_get_provider_info(Connection, provider, resources->config_timestamp), nullptr));
+			if (info)
+				addOutputs((void*)uintptr_t(provider), xcb_randr_get_provider_info_outputs(info.get()), xcb_randr_get_provider_info_outputs_length(info.get()));
+		}
+		return result;
+	}
+
+	std::optional<xcb_randr_output_t> GetOutput(GPUPortIdentifier portId)
+	{
+		if (!Connection)
+			return std::nullopt;
+		auto topology = GetTopology();
+		if (auto entry = topology->FindByPort(portId))
+			return xcb_randr_output_t(entry->DisplayId);
+		for (auto& display : EnumerateOutputs(false))
+			if (display.Port == portId)
+				return xcb_randr_output_t(display.DisplayId);
+		return std::nullopt;
+	}
+
+	std::optional<xcb_randr_mode_t> FindOrCreateMode(ScreenResources* resources, DisplayTiming const& timing)
+	{
+		char name[64];
+		int nameLength = std::snprintf(name, sizeof(name), "%ux%uR_%.3f", timing.HActive, timing.VActive, timing.RefreshRate());
+		// Mode names follow each other in the order of the modes
+		auto modes = xcb_randr_get_screen_resources_current_modes(resources);
+		auto names = (const char*)xcb_randr_get_screen_resources_current_names(resources);
+		for (int i = 0; i < xcb_randr_get_screen_resources_current_modes_length(resources); names += modes[i].name_len, ++i)
+			if (std::string_view(names, modes[i].name_len) == name)
+				return modes[i].id;
+		xcb_randr_mode_info_t mode{};
+		mode.width = uint16_t(timing.HActive);
+		mode.height = uint16_t(timing.VActive);
+		mode.dot_clock = uint32_t(timing.PixelClock);
+		mode.hsync_start = uint16_t(timing.HActive + timing.HFrontPorch);
+		mode.hsync_end = uint16_t(mode.hsync_start + timing.HSync);
+		mode.htotal = uint16_t(timing.HTotal());
+		mode.vsync_start = uint16_t(timing.VActive + timing.VFrontPorch);
+		mode.vsync_end = uint16_t(mode.vsync_start + timing.VSync);
+		mode.vtotal = uint16_t(timing.VTotal());
+		mode.name_len = uint16_t(nameLength);
+		mode.mode_flags = (timing.HSyncPositive ? XCB_RANDR_MODE_FLAG_HSYNC_POSITIVE : XCB_RANDR_MODE_FLAG_HSYNC_NEGATIVE) |
+						  (timing.VSyncPositive ? XCB_RANDR_MODE_FLAG_VSYNC_POSITIVE : XCB_RANDR_MODE_FLAG_VSYNC_NEGATIVE);
+		xcb_generic_error_t* error = nullptr;
+		XcbReply<xcb_randr_create_mode_reply_t> created(
+			xcb_randr_create_mode_reply(Connection, xcb_randr_create_mode(Connection, Root, mode, uint32_t(nameLength), name), &error));
+		auto errorText = TakeError(error);
+		if (!created || !created->mode)
+		{
+			nosEngine.LogE("Failed to create mode %s: %s", name, errorText ? errorText->c_str() : "no mode id");
+			return std::nullopt;
+		}
+		CreatedModes.insert(created->mode);
+		return created->mode;
+	}
+
+	// Removes a mode set by us from the output, and from the server if we created it and no other output of ours still
+	// runs it. Modes are shared by name, see FindOrCreateMode. A mode the server refuses to destroy is kept in CreatedModes,
+	// so that a later revert tries again.
+	void ForgetMode(xcb_randr_output_t output, xcb_randr_mode_t mode)
+	{
+		if (!mode)
+			return;
+		if (auto error = TakeError(xcb_request_check(Connection, xcb_randr_delete_output_mode_checked(Connection, output, mode))))
+		{
+			nosEngine.LogW("Failed to remove mode %u from output %u: %s", mode, output, error->c_str());
+			return;
+		}
+		if (!CreatedModes.contains(mode))
+			return;
+		for (auto& [port, applied] : Applied)
+			if (applied.Output != output && applied.Mode == mode)
+				return;
+		if (auto error = TakeError(xcb_request_check(Connection, xcb_randr_destroy_mode_checked(Connection, mode))))
+		{
+			nosEngine.LogW("Failed to destroy mode %u: %s", mode, error->c_str());
+			return;
+		}
+		CreatedModes.erase(mode);
+	}
+
+	// The screen has to contain every CRTC, it is grown up front when the new mode reaches past it
+	bool FitScreen(ScreenResources* resources, xcb_randr_crtc_t crtc, DisplayTiming const& timing, uint16_t rotation)
+	{
+		auto size = GetScreenSize();
+		auto required = size;
+		auto crtcs = xcb_randr_get_screen_resources_current_crtcs(resources);
+		for (int i = 0; i < xcb_randr_get_screen_resources_current_crtcs_length(resources); ++i)
+		{
+			auto info = GetCrtcInfo(resources, crtcs[i]);
+			if (!info || !info->mode)
+				continue;
+			nosVec2u extent = { info->width, info->height };
+			if (crtcs[i] == crtc)
+				extent = (rotation & (XCB_RANDR_ROTATION_ROTATE_90 | XCB_RANDR_ROTATION_ROTATE_270)) ? nosVec2u{ timing.VActive, timing.HActive }
+																									 : nosVec2u{ timing.HActive, timing.VActive };
+			required.x = std::max(required.x, uint32_t(info->x) + extent.x);
+			required.y = std::max(required.y, uint32_t(info->y) + extent.y);
+		}
+		if (required.x == size.x && required.y == size.y)
+			return true;
+		XcbReply<xcb_randr_get_screen_size_range_reply_t> range(
+			xcb_randr_get_screen_size_range_reply(Connection, xcb_randr_get_screen_size_range(Connection, Root), nullptr));
+		if (!range || required.x > range->max_width || required.y > range->max_height)
+		{
+			nosEngine.LogE("Screen would need to be %ux%u, the X server supports at most %ux%u", required.x, required.y, range ? range->max_width : 0u,
+						   range ? range->max_height : 0u);
+			return false;
+		}
+		auto sizeMM = GetScreenSizeMM(required);
+		auto cookie = xcb_randr_set_screen_size_checked(Connection, Root, uint16_t(required.x), uint16_t(required.y), sizeMM.x, sizeMM.y);
+		if (auto error = TakeError(xcb_request_check(Connection, cookie)))
+		{
+			nosEngine.LogE("Failed to resize the X screen to %ux%u: %s", required.x, required.y, error->c_str());
+			return false;
+		}
+		return true;
+	}
+
+	bool SetCrtcMode(ScreenResources* resources, std::string const& outputName, xcb_randr_crtc_t crtc, CrtcInfo* crtcInfo, xcb_randr_mode_t mode)
+	{
+		xcb_generic_error_t* error = nullptr;
+		XcbReply<xcb_randr_set_crtc_config_reply_t> reply(xcb_randr_set_crtc_config_reply(
+			Connection,
+			xcb_randr_set_crtc_config(Connection, crtc, XCB_CURRENT_TIME, resources->config_timestamp, crtcInfo->x, crtcInfo->y, mode, crtcInfo->rotation,
+									  uint32_t(xcb_randr_get_crtc_info_outputs_length(crtcInfo)), xcb_randr_get_crtc_info_outputs(crtcInfo)),
+			&error));
+		auto errorText = TakeError(error);
+		if (!reply || reply->status != XCB_RANDR_SET_CONFIG_SUCCESS)
+		{
+			nosEngine.LogE("Failed to set mode on output %s: %s", outputName.c_str(), errorText ? errorText->c_str() : "configuration refused");
+			return false;
+		}
+		return true;
+	}
+
+	// Returns false if the CRTC could not be put back, the mode set by us is then left in place
+	bool Restore(AppliedMode& applied)
+	{
+		auto resources = GetScreenResources();
+		if (!resources)
+			return false;
+		xcb_generic_error_t* error = nullptr;
+		XcbReply<xcb_randr_set_crtc_config_reply_t> reply(xcb_randr_set_crtc_config_reply(
+			Connection,
+			xcb_randr_set_crtc_config(Connection, applied.Crtc, XCB_CURRENT_TIME, resources->config_timestamp, applied.X, applied.Y, applied.OriginalMode,
+									  applied.OriginalRotation, uint32_t(applied.Outputs.size()), applied.Outputs.data()),
+			&error));
+		auto errorText = TakeError(error);
+		if (!reply || reply->status != XCB_RANDR_SET_CONFIG_SUCCESS)
+		{
+			nosEngine.LogE("Failed to restore the mode of CRTC %u: %s", applied.Crtc, errorText ? errorText->c_str() : "configuration refused");
+			return false;
+		}
+		// Shrinking fails while another output still needs the larger screen, which is fine
+		auto size = GetScreenSize();
+		if (size.x != applied.ScreenSize.x || size.y != applied.ScreenSize.y)
+		{
+			auto sizeMM = GetScreenSizeMM(applied.ScreenSize);
+			TakeError(xcb_request_check(Connection, xcb_randr_set_screen_size_checked(Connection, Root, uint16_t(applied.ScreenSize.x),
+																					  uint16_t(applied.ScreenSize.y), sizeMM.x, sizeMM.y)));
+		}
+		ForgetMode(applied.Output, std::exchange(applied.Mode, 0));
+		return true;
+	}
+
+	// A port that could not be restored keeps its entry, its original mode is still needed to try again
+	bool RevertResolution(GPUPortIdentifier portId, std::unique_lock<std::mutex>&)
+	{
+		auto it = Applied.find(portId);
+		if (it == Applied.end())
+			return true;
+		if (!Restore(it->second))
+			return false;
+		Applied.erase(it);
+		return true;
+	}
+
+	std::mutex Mutex;
+	xcb_connection_t* Connection = nullptr;
+	xcb_screen_t* Screen = nullptr;
+	xcb_window_t Root = 0;
+	bool HasProviders = false;
+	std::unordered_map<GPUPortIdentifier, AppliedMode, GPUPortIdentifierHash> Applied;
+	std::unordered_set<xcb_randr_mode_t> CreatedModes;
+};
+
+std::unique_ptr<CustomResolutionBase> TryCreateXRandRCustomResolution()
+{
+	return std::make_unique<XRandRCustomResolution>();
+}
+}
+#endif
@@ -0,0 +1,150 @@
+#include "MockCustomResolution.h"
+#include "Test.h"
+
+using namespace nos::display;
+using namespace nos::display::test;
+
+namespace
+{
+CustomResolutionInfo Mode(uint32_t width, uint32_t height, float refreshRate)
+{
+	return { .Resolution = { width, height }, .RefreshRate = refreshRate };
+}
+
+bool Runs(MockCustomResolution const& mock, uint32_t port, uint32_t width, uint32_t height)
+{
+	auto mode = mock.GetMode(port);
+	return mode && mode->HActive == width && mode->VActive == height;
+}
+}
+
+NOS_TEST(AppliesEveryPortInOneCall)
+{
+	MockCustomResolution mock(3);
+	auto P = MockCustomResolution::Port;
+	NOS_CHECK(mock.SetResolutionsAndRefreshRates({ { P(0), Mode(2560, 1440, 50) }, { P(1), Mode(2560, 1440, 50) }, { P(2), Mode(2560, 1440, 50) } }));
+	NOS_CHECK(mock.ApplyCalls == 1);
+	for (uint32_t port = 0; port < 3; ++port)
+	{
+		NOS_CHECK(Runs(mock, port, 2560, 1440));
+		auto applied = mock.GetAppliedResolution(P(port));
+		NOS_CHECK(applied && applied->Resolution.x == 2560 && applied->RefreshRate == 50);
+	}
+}
+
+NOS_TEST(RejectsAPortSetTwice)
+{
+	MockCustomResolution mock(2);
+	auto P = MockCustomResolution::Port;
+	NOS_CHECK(!mock.SetResolutionsAndRefreshRates({ { P(0), Mode(2560, 1440, 50) }, { P(0), Mode(1920, 1080, 60) } }));
+	NOS_CHECK(mock.ApplyCalls == 0);
+	NOS_CHECK(!mock.GetMode(0));
+}
+
+NOS_TEST(FailingPortRollsBackToOriginalModes)
+{
+	MockCustomResolution mock(3, { 2 });
+	auto P = MockCustomResolution::Port;
+	NOS_CHECK(!mock.SetResolutionsAndRefreshRates({ { P(0), Mode(2560, 1440, 50) }, { P(1), Mode(2560, 1440, 50) }, { P(2), Mode(2560, 1440, 50) } }));
+	// The mock switched ports 0 and 1 before port 2 refused, the rollback puts them back
+	for (uint32_t port = 0; port < 3; ++port)
+	{
+		NOS_CHECK(!mock.GetMode(port));
+		NOS_CHECK(!mock.GetAppliedResolution(P(port)));
+	}
+}
+
+NOS_TEST(FailingPortRollsBackToEarlierCustomModes)
+{
+	MockCustomResolution mock(3, { 2 });
+	auto P = MockCustomResolution::Port;
+	NOS_CHECK(mock.SetResolutionsAndRefreshRates({ { P(0), Mode(2560, 1440, 50) } }));
+	NOS_CHECK(!mock.SetResolutionsAndRefreshRates({ { P(0), Mode(1280, 720, 60) }, { P(1), Mode(1280, 720, 60) }, { P(2), Mode(1280, 720, 60) } }));
+	NOS_CHECK(Runs(mock, 0, 2560, 1440));
+	NOS_CHECK(!mock.GetMode(1));
+	auto applied = mock.GetAppliedResolution(P(0));
+	NOS_CHECK(applied && applied->Resolution.x == 2560);
+}
+
+NOS_TEST(UnknownPortFailsTheTransaction)
+{
+	MockCustomResolution mock(1);
+	auto P = MockCustomResolution::Port;
+	NOS_CHECK(!mock.SetResolutionsAndRefreshRates({ { P(0), Mode(2560, 1440, 50) }, { P(5), Mode(2560, 1440, 50) } }));
+	NOS_CHECK(!mock.GetMode(0));
+}
+
+NOS_TEST(UnresolvableTimingFailsTheTransaction)
+{
+	MockCustomResolution mock(2);
+	auto P = MockCustomResolution::Port;
+	auto beyondLink = Mode(7680, 4320, 240);
+	beyondLink.Link = DisplayLink::HDMI14;
+	NOS_CHECK(!mock.SetResolutionsAndRefreshRates({ { P(0), Mode(1920, 1080, 60) }, { P(1), beyondLink } }));
+	NOS_CHECK(!mock.GetMode(0));
+	NOS_CHECK(!mock.GetMode(1));
+}
+
+NOS_TEST(RevertRestoresOriginalModes)
+{
+	MockCustomResolution mock(3);
+	auto P = MockCustomResolution::Port;
+	NOS_CHECK(mock.SetResolutionsAndRefreshRates({ { P(0), Mode(2560, 1440, 50) }, { P(1), Mode(2560, 1440, 50) } }));
+	NOS_CHECK(mock.RevertResolutions({ P(0), P(1) }));
+	NOS_CHECK(!mock.GetMode(0));
+	NOS_CHECK(!mock.GetMode(1));
+	NOS_CHECK(!mock.GetAppliedResolution(P(0)));
+	NOS_CHECK(!mock.GetAppliedResolution(P(1)));
+}
+
+NOS_TEST(RevertLeavesPortsWithoutCustomModesAlone)
+{
+	MockCustomResolution mock(3);
+	auto P = MockCustomResolution::Port;
+	NOS_CHECK(mock.SetResolutionAndRefreshRate(P(0), Mode(2560, 1440, 50)));
+	auto revertsBefore = mock.RevertCalls;
+	NOS_CHECK(mock.RevertResolutions({ P(1), P(2) }));
+	NOS_CHECK(mock.RevertCalls == revertsBefore);
+	NOS_CHECK(Runs(mock, 0, 2560, 1440));
+}
+
+NOS_TEST(RepeatedModeStaysRevertible)
+{
+	MockCustomResolution mock(1);
+	auto P = MockCustomResolution::Port;
+	NOS_CHECK(mock.SetResolutionAndRefreshRate(P(0), Mode(2560, 1440, 50)));
+	NOS_CHECK(mock.SetResolutionAndRefreshRate(P(0), Mode(2560, 1440, 50)));
+	NOS_CHECK(mock.RevertResolution(P(0)));
+	NOS_CHECK(!mock.GetMode(0));
+}
+
+NOS_TEST(ModeAdoptedFromAnEarlierRunIsNeverReverted)
+{
+	auto P = MockCustomResolution::Port;
+	auto cachePath = std::filesystem::temp_directory_path() / "nosDisplayAdoptedModeTest.txt";
+	std::filesystem::remove(cachePath);
+	std::optional<DisplayTiming> left;
+	{
+		// The earlier run ends without reverting
+		MockCustomResolution earlier(2);
+		earlier.LoadCache(cachePath);
+		NOS_CHECK(earlier.SetResolutionAndRefreshRate(P(0), Mode(2560, 1440, 50)));
+		left = earlier.GetMode(0);
+	}
+	NOS_CHECK(left);
+	if (!left)
+		return;
+	MockCustomResolution mock(2);
+	mock.LoadCache(cachePath);
+	mock.SetMode(0, *left);
+	NOS_CHECK(mock.SetResolutionsAndRefreshRates({ { P(0), Mode(2560, 1440, 50) }, { P(1), Mode(2560, 1440, 50) } }));
+	NOS_CHECK(mock.ApplyCalls == 1 && Runs(mock, 1, 2560, 1440));
+	// The original mode of port 0 is unknown, every revert of it is refused and it stays as it is. Port 1 was switched
+	// by this run and is reverted all the same.
+	NOS_CHECK(!mock.RevertResolutions({ P(0), P(1) }));
+	NOS_CHECK(mock.RevertCalls == 1 && !mock.GetMode(1));
+	NOS_CHECK(!mock.RevertResolution(P(0)));
+	NOS_CHECK(mock.RevertCalls == 1 && Runs(mock, 0, 2560, 1440));
+	NOS_CHECK(mock.GetAppliedResolution(P(0)));
+	std::filesystem::remove(cachePath);
+}
@@ -0,0 +1,108 @@
+#include "DisplayTiming.h"
+#include "Test.h"
+
+#include <cmath>
+
+using namespace nos::display;
+
+namespace
+{
+// Modeline as printed by the cvt and gtf tools of X.Org: clock in MHz to two decimals, then the horizontal and
+// vertical active, sync start, sync end and total
+struct Modeline
+{
+	double ClockMHz;
+	uint32_t H[4];
+	uint32_t V[4];
+	bool HSyncPositive, VSyncPositive;
+};
+
+bool Matches(std::optional<DisplayTiming> const& timing, Modeline const& modeline)
+{
+	if (!timing)
+		return false;
+	auto& t = *timing;
+	return std::abs(t.PixelClock / 1e6 - modeline.ClockMHz) < 0.005 && t.HActive == modeline.H[0] && t.HActive + t.HFrontPorch == modeline.H[1] &&
+		   t.HActive + t.HFrontPorch + t.HSync == modeline.H[2] && t.HTotal() == modeline.H[3] && t.VActive == modeline.V[0] &&
+		   t.VActive + t.VFrontPorch == modeline.V[1] && t.VActive + t.VFrontPorch + t.VSync == modeline.V[2] && t.VTotal() == modeline.V[3] &&
+		   t.HSyncPositive == modeline.HSyncPositive && t.VSyncPositive == modeline.VSyncPositive;
+}
+}
+
+NOS_TEST(CVTMatchesReferenceModelines)
+{
+	NOS_CHECK(Matches(ComputeCVTTiming(1280, 720, 60), { 74.50, { 1280, 1344, 1472, 1664 }, { 720, 723, 728, 748 }, false, true }));
+	NOS_CHECK(Matches(ComputeCVTTiming(1920, 1080, 60), { 173.00, { 1920, 2048, 2248, 2576 }, { 1080, 1083, 1088, 1120 }, false, true }));
+	NOS_CHECK(Matches(ComputeCVTTiming(2560, 1440, 60), { 312.25, { 2560, 2752, 3024, 3488 }, { 1440, 1443, 1448, 1493 }, false, true }));
+}
+
+NOS_TEST(CVTReducedBlankingMatchesReferenceModelines)
+{
+	NOS_CHECK(Matches(ComputeCVTReducedBlankingTiming(1280, 720, 60), { 64.00, { 1280, 1328, 1360, 1440 }, { 720, 723, 728, 741 }, true, false }));
+	NOS_CHECK(Matches(ComputeCVTReducedBlankingTiming(1920, 1080, 60), { 138.50, { 1920, 1968, 2000, 2080 }, { 1080, 1083, 1088, 1111 }, true, false }));
+	NOS_CHECK(Matches(ComputeCVTReducedBlankingTiming(2560, 1440, 60), { 241.50, { 2560, 2608, 2640, 2720 }, { 1440, 1443, 1448, 1481 }, true, false }));
+}
+
+NOS_TEST(CVTReducedBlankingV2MatchesVESAExample)
+{
+	NOS_CHECK(Matches(ComputeCVTReducedBlankingV2Timing(1920, 1080, 60), { 133.32, { 1920, 1928, 1960, 2000 }, { 1080, 1097, 1105, 1111 }, true, false }));
+}
+
+NOS_TEST(GTFMatchesReferenceModelines)
+{
+	NOS_CHECK(Matches(ComputeGTFTiming(1920, 1080, 60), { 172.80, { 1920, 2040, 2248, 2576 }, { 1080, 1081, 1084, 1118 }, false, true }));
+	NOS_CHECK(Matches(ComputeGTFTiming(1280, 720, 60), { 74.48, { 1280, 1336, 1472, 1664 }, { 720, 721, 724, 746 }, false, true }));
+}
+
+NOS_TEST(BroadcastTableHitsRatesExactly)
+{
+	constexpr std::pair<uint32_t, uint32_t> resolutions[] = { { 1280, 720 }, { 1920, 1080 }, { 2560, 1440 }, { 3840, 2160 }, { 4096, 2160 } };
+	constexpr double rates[] = { 24, 25, 30, 48, 50, 60, 100, 120 };
+	constexpr double fractionalRates[] = { 24, 30, 48, 60, 120 };
+	auto check = [](uint32_t width, uint32_t height, double rate) {
+		auto timing = FindBroadcastTiming(width, height, rate);
+		NOS_CHECK(timing);
+		if (!timing)
+			return;
+		NOS_CHECK(timing->HActive == width && timing->VActive == height);
+		NOS_CHECK(std::abs(timing->RefreshRate() - rate) < 1e-3);
+		// CVT-RBv2 blanking: 80 pixels, and at least 460 us of vertical blanking
+		NOS_CHECK(timing->HTotal() - width == 80);
+		double vBlank = (timing->VTotal() - height) * timing->HTotal() / double(timing->PixelClock) * 1e6;
+		NOS_CHECK(vBlank >= 460.0);
+	};
+	for (auto [width, height] : resolutions)
+	{
+		for (double rate : rates)
+			check(width, height, rate);
+		for (double rate : fractionalRates)
+			check(width, height, rate * 1000.0 / 1001.0);
+	}
+	NOS_CHECK(!FindBroadcastTiming(1000, 1000, 60));
+	NOS_CHECK(!FindBroadcastTiming(1920, 1080, 75));
+}
+
+NOS_TEST(AutoPrefersTheBroadcastTable)
+{
+	auto timing = ComputeTiming(TimingStandard::Auto, 1920, 1080, 60000.0 / 1001);
+	NOS_CHECK(timing && std::abs(timing->RefreshRate() - 60000.0 / 1001) < 1e-3);
+	auto table = FindBroadcastTiming(1920, 1080, 60000.0 / 1001);
+	NOS_CHECK(timing && table && timing->PixelClock == table->PixelClock);
+	NOS_CHECK(ComputeTiming(TimingStandard::CVT, 1920, 1080, 60)->PixelClock == 173000000);
+}
+
+NOS_TEST(LinksBoundThePixelClock)
+{
+	NOS_CHECK(GetMaxPixelClock(DisplayLink::Unknown, 24) == 0);
+	NOS_CHECK(GetMaxPixelClock(DisplayLink::HDMI14, 24) >= 297000000);
+	NOS_CHECK(GetMaxPixelClock(DisplayLink::HDMI14, 24) < 594000000);
+	NOS_CHECK(GetMaxPixelClock(DisplayLink::HDMI20, 24) >= 594000000);
+	NOS_CHECK(GetMaxPixelClock(DisplayLink::HDMI20, 30) < GetMaxPixelClock(DisplayLink::HDMI20, 24));
+	NOS_CHECK(GetMaxPixelClock(DisplayLink::DisplayPort14, 24) > GetMaxPixelClock(DisplayLink::DisplayPort12, 24));
+}
+
+NOS_TEST(RejectsUnreachableModes)
+{
+	NOS_CHECK(!ComputeCVTTiming(0, 1080, 60));
+	NOS_CHECK(!ComputeCVTReducedBlankingV2Timing(1920, 1080, 0));
+}
@@ -0,0 +1,147 @@
+#include "EDID.h"
+#include "Test.h"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+using namespace nos::display;
+
+namespace
+{
+// Fixtures are whitespace separated hex bytes, like the output of edid-decode or xxd -p
+std::vector<uint8_t> LoadFixture(const char* name)
+{
+	std::ifstream file(std::filesystem::path(NOSDISPLAY_EDID_FIXTURE_DIR) / name);
+	std::vector<uint8_t> edid;
+	std::string byte;
+	while (file >> byte)
+		edid.push_back(uint8_t(std::stoul(byte, nullptr, 16)));
+	NOS_CHECK(!edid.empty() && edid.size() % 128 == 0);
+	return edid;
+}
+
+bool IsTiming(DisplayTiming const& timing, uint32_t width, uint32_t height, uint64_t pixelClock, uint32_t hTotal, uint32_t vTotal)
+{
+	return timing.HActive == width && timing.VActive == height && timing.PixelClock == pixelClock && timing.HTotal() == hTotal && timing.VTotal() == vTotal;
+}
+}
+
+NOS_TEST(ParsesDVIPanel)
+{
+	auto caps = ParseEDID(LoadFixture("DVI-1080p60.hex"));
+	NOS_CHECK(caps);
+	if (!caps)
+		return;
+	NOS_CHECK(caps->ManufacturerId == "NOS");
+	NOS_CHECK(caps->ProductCode == 0x0101);
+	NOS_CHECK(caps->SerialNumber == 1001);
+	NOS_CHECK(caps->MonitorName == "NOS DVI");
+	// EDID 1.3 has no interface field and no continuous frequency flag
+	NOS_CHECK(caps->Interface == EDIDInterface::Undefined);
+	NOS_CHECK(!caps->ContinuousFrequency);
+	NOS_CHECK(caps->DetailedTimings.size() == 1);
+	auto native = caps->GetNativeTiming();
+	NOS_CHECK(native && IsTiming(*native, 1920, 1080, 148500000, 2200, 1125));
+	NOS_CHECK(native && native->HSyncPositive && native->VSyncPositive);
+	NOS_CHECK(caps->RangeLimits);
+	if (caps->RangeLimits)
+	{
+		NOS_CHECK(caps->RangeLimits->MinVerticalRate == 56 && caps->RangeLimits->MaxVerticalRate == 76);
+		NOS_CHECK(caps->RangeLimits->MinHorizontalRate == 30 && caps->RangeLimits->MaxHorizontalRate == 83);
+		NOS_CHECK(caps->RangeLimits->MaxPixelClock == 170000000);
+	}
+	NOS_CHECK(!caps->VRR);
+	NOS_CHECK(!caps->HDR);
+	NOS_CHECK(caps->GetMaxPixelClock(24) == 170000000);
+}
+
+NOS_TEST(RejectsTimingsOutsideRangeLimits)
+{
+	auto caps = ParseEDID(LoadFixture("DVI-1080p60.hex"));
+	NOS_CHECK(caps);
+	if (!caps)
+		return;
+	NOS_CHECK(!caps->Reject(*caps->GetNativeTiming(), 24));
+	NOS_CHECK(!caps->Reject(*ComputeCVTReducedBlankingTiming(1920, 1080, 60), 24));
+	// 59.94 is within a 60 Hz limit
+	NOS_CHECK(!caps->Reject(*ComputeTiming(TimingStandard::Auto, 1920, 1080, 60000.0 / 1001), 24));
+	NOS_CHECK(caps->Reject(*ComputeCVTTiming(3840, 2160, 60), 24));
+	NOS_CHECK(caps->Reject(*ComputeCVTReducedBlankingTiming(1920, 1080, 120), 24));
+	NOS_CHECK(caps->Reject(*ComputeCVTReducedBlankingTiming(1920, 1080, 30), 24));
+}
+
+NOS_TEST(ParsesHDMIVendorAndHDRBlocks)
+{
+	auto caps = ParseEDID(LoadFixture("HDMI-2160p60-HDR.hex"));
+	NOS_CHECK(caps);
+	if (!caps)
+		return;
+	NOS_CHECK(caps->MonitorName == "NOS HDMI TV");
+	NOS_CHECK(caps->DetailedTimings.size() == 2);
+	auto native = caps->GetNativeTiming();
+	NOS_CHECK(native && IsTiming(*native, 3840, 2160, 594000000, 4400, 2250));
+	NOS_CHECK(IsTiming(caps->DetailedTimings.back(), 1920, 1080, 148500000, 2200, 1125));
+	// The HDMI Forum block raises the 300 MHz of the HDMI 1.4 block
+	NOS_CHECK(caps->MaxTMDSClock == 600000000);
+	NOS_CHECK(caps->MaxFRLBitRate == 4 * 6000000000ull);
+	NOS_CHECK(caps->VRR && caps->VRR->Min == 48 && caps->VRR->Max == 60);
+	NOS_CHECK(caps->HDR);
+	if (caps->HDR)
+	{
+		NOS_CHECK(caps->HDR->TraditionalSDR && !caps->HDR->TraditionalHDR && caps->HDR->PQ && caps->HDR->HLG);
+		NOS_CHECK(std::abs(caps->HDR->MaxLuminance - 400.0f) < 0.01f);
+		NOS_CHECK(std::abs(caps->HDR->MaxFrameAverageLuminance - 282.84f) < 0.01f);
+		NOS_CHECK(std::abs(caps->HDR->MinLuminance - 0.0984f) < 0.0001f);
+	}
+	// FRL carries more than the range limits allow, those bound the pixel clock
+	NOS_CHECK(caps->GetMaxPixelClock(24) == 600000000);
+	NOS_CHECK(!caps->Reject(*native, 30));
+}
+
+NOS_TEST(ParsesDisplayPortAdaptiveSync)
+{
+	auto caps = ParseEDID(LoadFixture("DP-1440p165-AdaptiveSync.hex"));
+	NOS_CHECK(caps);
+	if (!caps)
+		return;
+	NOS_CHECK(caps->Interface == EDIDInterface::DisplayPort);
+	NOS_CHECK(caps->ContinuousFrequency);
+	// The preferred DisplayID timing goes ahead of the base block's
+	NOS_CHECK(caps->DetailedTimings.size() == 2);
+	auto native = caps->GetNativeTiming();
+	NOS_CHECK(native && IsTiming(*native, 2560, 1440, 684420000, 2720, 1525));
+	NOS_CHECK(native && native->HSyncPositive && !native->VSyncPositive);
+	NOS_CHECK(IsTiming(caps->DetailedTimings.back(), 2560, 1440, 597310000, 2720, 1525));
+	NOS_CHECK(caps->VRR && caps->VRR->Min == 48 && caps->VRR->Max == 165);
+	NOS_CHECK(caps->GetMaxPixelClock(24) == 700000000);
+}
+
+NOS_TEST(SkipsExtensionsWithBadChecksum)
+{
+	auto caps = ParseEDID(LoadFixture("DVI-1080p60-BadExtension.hex"));
+	NOS_CHECK(caps);
+	if (!caps)
+		return;
+	NOS_CHECK(caps->MonitorName == "NOS DVI");
+	NOS_CHECK(caps->DetailedTimings.size() == 1);
+	NOS_CHECK(caps->MaxTMDSClock == 0);
+	NOS_CHECK(!caps->VRR);
+}
+
+NOS_TEST(RejectsInvalidBaseBlocks)
+{
+	auto edid = LoadFixture("DVI-1080p60.hex");
+	NOS_CHECK(!ParseEDID(std::span(edid).first(127)));
+	auto badHeader = edid;
+	badHeader[0] = 0x01;
+	NOS_CHECK(!ParseEDID(badHeader));
+	auto badChecksum = edid;
+	badChecksum[127] ^= 0x01;
+	NOS_CHECK(!ParseEDID(badChecksum));
+	// An extension count beyond the blob is cut to what is there
+	auto missingExtension = edid;
+	missingExtension[126] = 1;
+	missingExtension[127] -= 1;
+	NOS_CHECK(ParseEDID(missingExtension));
+}
@@ -0,0 +1,184 @@
+#include "FramePacer.h"
+#include "Test.h"
+
+#include <vector>
+
+using namespace nos::display;
+using namespace std::chrono_literals;
+
+namespace
+{
+// Clock that only moves when told to. SleepFor oversleeps by Oversleep, like a coarse OS timer, and every Spin
+// advances by SpinStep.
+struct FakePacingClock : PacingClock
+{
+	TimePoint Now() override { return Time; }
+	void SleepFor(Duration duration) override
+	{
+		Sleeps.push_back(duration);
+		Time += duration + Oversleep;
+	}
+	void Spin() override
+	{
+		++Spins;
+		Time += SpinStep;
+	}
+
+	void Advance(Duration duration) { Time += duration; }
+
+	TimePoint Time{ 1s };
+	Duration Oversleep{};
+	Duration SpinStep = 10us;
+	std::vector<Duration> Sleeps;
+	uint64_t Spins = 0;
+};
+
+// The statistics are kept in double seconds, allow for the rounding back to nanoseconds
+bool IsNear(PacingClock::Duration a, PacingClock::Duration b)
+{
+	return a - b < 10ns && b - a < 10ns;
+}
+
+constexpr auto Period60 = std::chrono::duration_cast<PacingClock::Duration>(std::chrono::duration<double>(1.0 / 60));
+}
+
+NOS_TEST(FirstFrameIsReleasedRightAway)
+{
+	FakePacingClock clock;
+	FramePacer pacer(clock);
+	pacer.SetTargetRate(60);
+	NOS_CHECK(pacer.GetTargetInterval() == Period60);
+	NOS_CHECK(!pacer.GetNextDeadline());
+	auto start = clock.Time;
+	NOS_CHECK(pacer.WaitForNextFrame() == start);
+	NOS_CHECK(clock.Sleeps.empty() && clock.Spins == 0);
+	NOS_CHECK(pacer.GetNextDeadline() == start + Period60);
+}
+
+NOS_TEST(SleepsUntilTheSpinMarginThenSpins)
+{
+	FakePacingClock clock;
+	FramePacer pacer(clock);
+	pacer.SetTargetRate(60);
+	pacer.SetSpinMargin(1ms);
+	auto start = pacer.WaitForNextFrame();
+	for (int frame = 1; frame <= 10; ++frame)
+	{
+		clock.Advance(2ms); // Work of the frame
+		auto workDone = clock.Time;
+		auto spinsBefore = clock.Spins;
+		clock.Sleeps.clear();
+		auto deadline = start + frame * Period60;
+		auto released = pacer.WaitForNextFrame();
+		NOS_CHECK(released >= deadline && released < deadline + clock.SpinStep);
+		NOS_CHECK(clock.Sleeps.size() == 1 && clock.Sleeps[0] == deadline - workDone - 1ms);
+		NOS_CHECK(clock.Spins - spinsBefore == uint64_t((1ms + clock.SpinStep - 1ns) / clock.SpinStep));
+	}
+	NOS_CHECK(pacer.GetLateFrameCount() == 0);
+}
+
+NOS_TEST(OversleepDoesNotDriftTheDeadlines)
+{
+	FakePacingClock clock;
+	clock.Oversleep = 500us;
+	FramePacer pacer(clock);
+	pacer.SetTargetRate(60);
+	pacer.SetSpinMargin(1ms);
+	auto start = pacer.WaitForNextFrame();
+	PacingClock::TimePoint released;
+	for (int frame = 1; frame <= 600; ++frame)
+		released = pacer.WaitForNextFrame();
+	// Ten seconds of frames still end on the 600th deadline, the margin absorbs the oversleep
+	NOS_CHECK(released >= start + 600 * Period60 && released < start + 600 * Period60 + clock.SpinStep);
+	NOS_CHECK(pacer.GetLateFrameCount() == 0);
+}
+
+NOS_TEST(SlightlyLateFramesKeepTheCadence)
+{
+	FakePacingClock clock;
+	FramePacer pacer(clock);
+	pacer.SetTargetRate(60);
+	auto start = pacer.WaitForNextFrame();
+	// Less than a period behind: released at once, the next deadline stays on the original grid
+	clock.Advance(Period60 + 5ms);
+	NOS_CHECK(pacer.WaitForNextFrame() == start + Period60 + 5ms);
+	NOS_CHECK(pacer.GetNextDeadline() == start + 2 * Period60);
+	NOS_CHECK(pacer.GetLateFrameCount() == 0);
+}
+
+NOS_TEST(StallsStartANewDeadlineChainInsteadOfBursting)
+{
+	FakePacingClock clock;
+	FramePacer pacer(clock);
+	pacer.SetTargetRate(60);
+	pacer.WaitForNextFrame();
+	clock.Advance(100ms);
+	auto resumed = pacer.WaitForNextFrame();
+	NOS_CHECK(resumed == clock.Time);
+	NOS_CHECK(pacer.GetLateFrameCount() == 1);
+	NOS_CHECK(pacer.GetNextDeadline() == resumed + Period60);
+	// The frame after the stall waits a full period again
+	NOS_CHECK(pacer.WaitForNextFrame() >= resumed + Period60);
+	NOS_CHECK(pacer.GetLateFrameCount() == 1);
+}
+
+NOS_TEST(TryReleaseFrameNeverWaits)
+{
+	FakePacingClock clock;
+	FramePacer pacer(clock);
+	pacer.SetTargetRate(50);
+	auto start = pacer.TryReleaseFrame();
+	NOS_CHECK(start == clock.Time);
+	clock.Advance(19ms);
+	NOS_CHECK(!pacer.TryReleaseFrame());
+	clock.Advance(1ms);
+	NOS_CHECK(pacer.TryReleaseFrame() == *start + 20ms);
+	NOS_CHECK(clock.Sleeps.empty() && clock.Spins == 0);
+	NOS_CHECK(pacer.GetNextDeadline() == *start + 40ms);
+}
+
+NOS_TEST(ReportsAchievedIntervalAndJitter)
+{
+	FakePacingClock clock;
+	FramePacer pacer(clock);
+	pacer.SetTargetRate(50);
+	pacer.TryReleaseFrame();
+	// Intervals alternate 2ms over and 2ms under the 20ms target
+	for (int frame = 0; frame < 10; ++frame)
+	{
+		clock.Advance(frame % 2 ? 18ms : 22ms);
+		pacer.MarkFrame();
+	}
+	NOS_CHECK(IsNear(pacer.GetAchievedInterval(), 20ms));
+	NOS_CHECK(IsNear(pacer.GetJitter(), 2ms));
+}
+
+NOS_TEST(WithoutATargetFramesAreOnlyMarked)
+{
+	FakePacingClock clock;
+	FramePacer pacer(clock);
+	NOS_CHECK(pacer.GetTargetInterval() == FramePacer::Duration::zero());
+	auto first = pacer.WaitForNextFrame();
+	clock.Advance(7ms);
+	NOS_CHECK(pacer.WaitForNextFrame() == first + 7ms);
+	NOS_CHECK(pacer.TryReleaseFrame() == first + 7ms);
+	NOS_CHECK(!pacer.GetNextDeadline());
+	NOS_CHECK(clock.Sleeps.empty() && clock.Spins == 0);
+}
+
+NOS_TEST(ChangingTheRateResetsTheChain)
+{
+	FakePacingClock clock;
+	FramePacer pacer(clock);
+	pacer.SetTargetRate(60);
+	pacer.WaitForNextFrame();
+	clock.Advance(100ms);
+	pacer.WaitForNextFrame();
+	NOS_CHECK(pacer.GetLateFrameCount() == 1);
+	// Same rate again keeps the state
+	pacer.SetTargetRate(60);
+	NOS_CHECK(pacer.GetLateFrameCount() == 1 && pacer.GetNextDeadline());
+	pacer.SetTargetRate(30);
+	NOS_CHECK(pacer.GetLateFrameCount() == 0 && !pacer.GetNextDeadline());
+	NOS_CHECK(pacer.GetAchievedInterval() == FramePacer::Duration::zero());
+}
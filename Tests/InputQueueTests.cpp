@@ -0,0 +1,108 @@
+#include "InputQueue.h"
+#include "Test.h"
+
+using namespace nos::display;
+
+namespace
+{
+nosResourceShareInfo Texture(uint64_t handle)
+{
+	nosResourceShareInfo texture{};
+	texture.Memory.Handle = handle;
+	return texture;
+}
+
+uint64_t HandleOf(std::optional<nosResourceShareInfo> const& input)
+{
+	return input ? input->Memory.Handle : 0;
+}
+}
+
+NOS_TEST(LatestPresentsNothingWithoutANewFrame)
+{
+	InputQueue inputs;
+	inputs.Receive(Texture(1), 1);
+	inputs.Receive(Texture(2), 2);
+	NOS_CHECK(HandleOf(inputs.Next(InputPolicy::Latest, false)) == 2);
+	NOS_CHECK(inputs.Dropped == 1);
+	NOS_CHECK(!inputs.Next(InputPolicy::Latest, false));
+	// The same upstream frame received again is not a new input
+	inputs.Receive(Texture(2), 2);
+	NOS_CHECK(!inputs.Next(InputPolicy::Latest, false));
+	NOS_CHECK(inputs.Repeated == 0);
+	// Unless a new swapchain needs something to show
+	NOS_CHECK(HandleOf(inputs.Next(InputPolicy::Latest, true)) == 2);
+	NOS_CHECK(inputs.Repeated == 1);
+}
+
+NOS_TEST(RepeatLastPresentsTheLastInputAgain)
+{
+	InputQueue inputs;
+	NOS_CHECK(!inputs.Next(InputPolicy::RepeatLast, false));
+	inputs.Receive(Texture(1), 1);
+	NOS_CHECK(HandleOf(inputs.Next(InputPolicy::RepeatLast, false)) == 1);
+	NOS_CHECK(HandleOf(inputs.Next(InputPolicy::RepeatLast, false)) == 1);
+	NOS_CHECK(HandleOf(inputs.Next(InputPolicy::RepeatLast, false)) == 1);
+	NOS_CHECK(inputs.Repeated == 2);
+	// An upstream that rewrites one texture still brings a new frame
+	inputs.Receive(Texture(1), 2);
+	NOS_CHECK(HandleOf(inputs.Next(InputPolicy::RepeatLast, false)) == 1);
+	NOS_CHECK(inputs.Repeated == 2 && inputs.Dropped == 0);
+}
+
+NOS_TEST(FIFODrainsInOrder)
+{
+	InputQueue inputs;
+	for (uint64_t frame = 1; frame <= 3; ++frame)
+		inputs.Receive(Texture(frame), frame);
+	NOS_CHECK(HandleOf(inputs.Next(InputPolicy::FIFO, false)) == 1);
+	NOS_CHECK(HandleOf(inputs.Next(InputPolicy::FIFO, false)) == 2);
+	NOS_CHECK(HandleOf(inputs.Next(InputPolicy::FIFO, false)) == 3);
+	NOS_CHECK(!inputs.Next(InputPolicy::FIFO, false));
+	NOS_CHECK(inputs.Dropped == 0 && inputs.Repeated == 0);
+	// A full ring drops the oldest input
+	for (uint64_t frame = 4; frame <= 8; ++frame)
+		inputs.Receive(Texture(frame), frame);
+	NOS_CHECK(inputs.Dropped == 1);
+	NOS_CHECK(HandleOf(inputs.Next(InputPolicy::FIFO, false)) == 5);
+}
+
+NOS_TEST(OverwrittenTextureIsDropped)
+{
+	InputQueue inputs;
+	inputs.Receive(Texture(1), 1);
+	inputs.Receive(Texture(2), 2);
+	// Upstream rendered frame 3 into the texture of frame 1, which was not presented yet
+	inputs.Receive(Texture(1), 3);
+	NOS_CHECK(inputs.Dropped == 1);
+	NOS_CHECK(HandleOf(inputs.Next(InputPolicy::FIFO, false)) == 2);
+	NOS_CHECK(HandleOf(inputs.Next(InputPolicy::FIFO, false)) == 1);
+	NOS_CHECK(!inputs.Next(InputPolicy::FIFO, false));
+}
+
+NOS_TEST(PutBackInputIsKeptWhenItsTextureIsReused)
+{
+	InputQueue inputs;
+	inputs.Receive(Texture(1), 1);
+	auto taken = inputs.Next(InputPolicy::FIFO, false);
+	NOS_CHECK(HandleOf(taken) == 1);
+	// The acquire timed out and Retry hands the input back, then upstream renders into the same texture again
+	inputs.PutBack(*taken);
+	inputs.Receive(Texture(1), 2);
+	NOS_CHECK(inputs.Dropped == 0);
+	NOS_CHECK(HandleOf(inputs.Next(InputPolicy::FIFO, false)) == 1);
+	NOS_CHECK(HandleOf(inputs.Next(InputPolicy::FIFO, false)) == 1);
+	NOS_CHECK(!inputs.Next(InputPolicy::FIFO, false));
+}
+
+NOS_TEST(ClearForgetsTheLastInput)
+{
+	InputQueue inputs;
+	inputs.Receive(Texture(1), 1);
+	inputs.Next(InputPolicy::RepeatLast, false);
+	inputs.Clear();
+	NOS_CHECK(!inputs.Next(InputPolicy::RepeatLast, false));
+	// Frames are counted again after a clear
+	inputs.Receive(Texture(2), 1);
+	NOS_CHECK(HandleOf(inputs.Next(InputPolicy::Latest, false)) == 2);
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "CustomResolutionBase.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <unordered_set>
+
+namespace nos::display::test
+{
+// Driverless backend for exercising the transaction logic, constructed by the tests in place of the platform one.
+// Ports 0 to displayCount - 1 are simulated, ports in FailingPorts refuse every mode. The window system names the
+// display on port n "Mock-n". Modes are applied one port at a
+// time like a backend without batching, a failing port leaves the ones before it changed.
+struct MockCustomResolution : CustomResolutionBase
+{
+	MockCustomResolution(uint32_t displayCount, std::unordered_set<uint32_t> failingPorts = {})
+		: DisplayCount(displayCount), FailingPorts(std::move(failingPorts))
+	{
+		RefreshTopology({});
+	}
+
+	bool Init() override
+	{
+		return true;
+	}
+
+	void Shutdown() override
+	{
+		Modes.clear();
+	}
+
+protected:
+	bool ApplyModes(std::vector<CustomResolutionRequest> const& requests) override
+	{
+		++ApplyCalls;
+		for (auto& request : requests)
+		{
+			auto timing = ResolveTiming(request.Port, request.Info);
+			if (!timing)
+				return false;
+			if (!IsPort(request.Port) || FailingPorts.contains(request.Port.PortId))
+			{
+				nosEngine.LogE("Mock display %u refused %ux%u@%.3f", request.Port.PortId, timing->HActive, timing->VActive, timing->RefreshRate());
+				return false;
+			}
+			Modes[request.Port.PortId] = *timing;
+			nosEngine.LogI("Mock display %u runs %ux%u@%.3f", request.Port.PortId, timing->HActive, timing->VActive, timing->RefreshRate());
+		}
+		return true;
+	}
+
+	bool RevertModes(std::vector<GPUPortIdentifier> const& portIds) override
+	{
+		++RevertCalls;
+		for (auto& portId : portIds)
+			if (Modes.erase(portId.PortId))
+				nosEngine.LogI("Mock display %u runs its original mode", portId.PortId);
+		return true;
+	}
+
+	std::optional<DisplayTiming> GetCurrentTiming(GPUPortIdentifier portId) override
+	{
+		if (!IsPort(portId))
+			return std::nullopt;
+		if (auto it = Modes.find(portId.PortId); it != Modes.end())
+			return it->second;
+		// Every simulated display starts in the preferred timing of its EDID
+		if (auto edid = ReadEDID(portId))
+			if (auto capabilities = ParseEDID(*edid))
+				return capabilities->GetNativeTiming();
+		return std::nullopt;
+	}
+
+	// EDID 1.4 base block of a 1080p60 panel made by "NOS", the port is the product code so each display hashes differently
+	std::optional<std::vector<uint8_t>> ReadEDID(GPUPortIdentifier portId) override
+	{
+		if (!IsPort(portId))
+			return std::nullopt;
+		++EDIDReads;
+		constexpr uint8_t Header[] = { 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00 };
+		constexpr uint8_t PreferredTiming[] = { 0x02, 0x3A, 0x80, 0x18, 0x71, 0x38, 0x2D, 0x40, 0x58, 0x2C, 0x45, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1E };
+		std::vector<uint8_t> edid(128);
+		std::copy(std::begin(Header), std::end(Header), edid.begin());
+		edid[8] = 0x39;
+		edid[9] = 0xF3;
+		edid[10] = uint8_t(portId.PortId);
+		edid[11] = uint8_t(portId.PortId >> 8);
+		if (auto it = SerialNumbers.find(portId.PortId); it != SerialNumbers.end())
+			for (int i = 0; i < 4; ++i)
+				edid[12 + i] = uint8_t(it->second >> (8 * i));
+		edid[18] = 1;
+		edid[19] = 4;
+		edid[20] = 0xA5;
+		std::copy(std::begin(PreferredTiming), std::end(PreferredTiming), edid.begin() + 54);
+		edid[127] = uint8_t(-std::accumulate(edid.begin(), edid.end() - 1, 0));
+		return edid;
+	}
+
+	std::optional<uint32_t> GetDisplayIdFromAdapterName(const char* adapterName) override
+	{
+		uint32_t displayId = 0;
+		if (std::sscanf(adapterName, "Mock-%u", &displayId) != 1)
+			return std::nullopt;
+		return displayId;
+	}
+
+	std::optional<GPUPortIdentifier> GetPortFromDisplayId(uint32_t displayId) override
+	{
+		if (displayId >= DisplayCount)
+			return std::nullopt;
+		return GPUPortIdentifier{ .GPUId = nullptr, .PortId = displayId };
+	}
+
+	std::optional<uint32_t> GetGPUBusId(void* gpuId) override
+	{
+		return 0;
+	}
+
+	std::vector<DisplayPortInfo> EnumerateActiveDisplays() override
+	{
+		std::vector<DisplayPortInfo> result;
+		for (uint32_t i = 0; i < DisplayCount; ++i)
+			result.push_back({ .Port = { .GPUId = nullptr, .PortId = i }, .DisplayId = i });
+		return result;
+	}
+
+public:
+	static GPUPortIdentifier Port(uint32_t portId) { return { .GPUId = nullptr, .PortId = portId }; }
+	// Custom mode the display on portId runs, nothing while it runs its original one
+	std::optional<DisplayTiming> GetMode(uint32_t portId) const
+	{
+		if (auto it = Modes.find(portId); it != Modes.end())
+			return it->second;
+		return std::nullopt;
+	}
+	// Stands for a mode another process left on the display
+	void SetMode(uint32_t portId, DisplayTiming const& timing) { Modes[portId] = timing; }
+	// Shares the cache file with other mocks, like consecutive runs of the plugin do
+	void LoadCache(std::filesystem::path path) { LoadTimingCache(std::move(path)); }
+
+	uint32_t DisplayCount = 0;
+	std::unordered_set<uint32_t> FailingPorts;
+	// Serial number of the display on a port, unlisted ones have none. Changing it stands for plugging in another display.
+	std::unordered_map<uint32_t, uint32_t> SerialNumbers;
+	uint32_t EDIDReads = 0;
+	uint32_t ApplyCalls = 0;
+	uint32_t RevertCalls = 0;
+
+private:
+	bool IsPort(GPUPortIdentifier portId) const { return !portId.GPUId && portId.PortId < DisplayCount; }
+
+	std::unordered_map<uint32_t, DisplayTiming> Modes; // Ports running their original mode are not listed
+};
+}
@@ -0,0 +1,152 @@
+#include "PresentSwapchain.h"
+#include "Test.h"
+
+using namespace nos::display;
+
+NOS_TEST(SwapchainNeedsASurface)
+{
+	NullPresentBackend backend;
+	std::vector<nosResourceShareInfo> images;
+	NOS_CHECK(!backend.CreateSwapchain({ 1920, 1080 }, NOS_PRESENT_MODE_FIFO, images));
+	NOS_CHECK(backend.CreateSurface(nullptr) && backend.HasSurface());
+	NOS_CHECK(!backend.CreateSwapchain({ 0, 1080 }, NOS_PRESENT_MODE_FIFO, images));
+	NOS_CHECK(backend.CreateSwapchain({ 1920, 1080 }, NOS_PRESENT_MODE_FIFO, images) && backend.HasSwapchain());
+	NOS_CHECK(images.size() == 2 && images[0].Info.Texture.Width == 1920 && images[0].Info.Texture.Height == 1080);
+	backend.DestroySwapchain();
+	NOS_CHECK(!backend.HasSwapchain());
+	uint32_t imageIndex = 0;
+	NOS_CHECK(backend.AcquireNextImage(0, &imageIndex, {}) == NOS_RESULT_FAILED);
+}
+
+NOS_TEST(UnsupportedModesFallBackToFIFO)
+{
+	NullPresentBackend backend;
+	backend.CreateSurface(nullptr);
+	backend.SupportedPresentModes = { NOS_PRESENT_MODE_FIFO };
+	std::vector<nosResourceShareInfo> images;
+	NOS_CHECK(CreateSwapchainWithFallback(backend, { 1280, 720 }, NOS_PRESENT_MODE_MAILBOX, images) == NOS_PRESENT_MODE_FIFO);
+	NOS_CHECK(backend.PresentMode == NOS_PRESENT_MODE_FIFO);
+	backend.SupportedPresentModes.push_back(NOS_PRESENT_MODE_MAILBOX);
+	NOS_CHECK(CreateSwapchainWithFallback(backend, { 1280, 720 }, NOS_PRESENT_MODE_MAILBOX, images) == NOS_PRESENT_MODE_MAILBOX);
+	NOS_CHECK(images.size() == 3);
+	// Immediate walks down the latency order and stops at the first supported mode
+	NOS_CHECK(CreateSwapchainWithFallback(backend, { 1280, 720 }, NOS_PRESENT_MODE_IMMEDIATE, images) == NOS_PRESENT_MODE_MAILBOX);
+	backend.SupportedPresentModes = { NOS_PRESENT_MODE_FIFO_RELAXED, NOS_PRESENT_MODE_FIFO };
+	NOS_CHECK(CreateSwapchainWithFallback(backend, { 1280, 720 }, NOS_PRESENT_MODE_IMMEDIATE, images) == NOS_PRESENT_MODE_FIFO_RELAXED);
+	NOS_CHECK(CreateSwapchainWithFallback(backend, { 1280, 720 }, NOS_PRESENT_MODE_MAILBOX, images) == NOS_PRESENT_MODE_FIFO_RELAXED);
+	// Lower latency modes are never picked for a higher latency request
+	backend.SupportedPresentModes = { NOS_PRESENT_MODE_IMMEDIATE, NOS_PRESENT_MODE_FIFO };
+	NOS_CHECK(CreateSwapchainWithFallback(backend, { 1280, 720 }, NOS_PRESENT_MODE_FIFO_RELAXED, images) == NOS_PRESENT_MODE_FIFO);
+	NOS_CHECK(ParsePresentMode(GetPresentModeName(NOS_PRESENT_MODE_FIFO_RELAXED)) == NOS_PRESENT_MODE_FIFO_RELAXED);
+	NOS_CHECK(!ParsePresentMode("VSync"));
+}
+
+NOS_TEST(ImagesAreAcquiredInTurn)
+{
+	NullPresentBackend backend;
+	backend.CreateSurface(nullptr);
+	PresentSwapchain swapchain;
+	NOS_CHECK(swapchain.Create(backend, { 1920, 1080 }, NOS_PRESENT_MODE_MAILBOX, 2));
+	for (uint32_t frame = 0; frame < 9; ++frame)
+	{
+		uint32_t imageIndex = ~0u;
+		NOS_CHECK(backend.AcquireNextImage(0, &imageIndex, swapchain.AcquireSemaphores[frame % 2]) == NOS_RESULT_SUCCESS);
+		NOS_CHECK(imageIndex == frame % 3);
+		NOS_CHECK(backend.Present(imageIndex, swapchain.PresentSemaphores[imageIndex]) == NOS_RESULT_SUCCESS);
+	}
+	NOS_CHECK(backend.FramesPresented == 9);
+}
+
+NOS_TEST(StalledAcquireTimesOut)
+{
+	NullPresentBackend backend;
+	backend.CreateSurface(nullptr);
+	PresentSwapchain swapchain;
+	swapchain.Create(backend, { 1920, 1080 }, NOS_PRESENT_MODE_FIFO, 2);
+	backend.SetStalled(true);
+	uint32_t imageIndex = 0;
+	NOS_CHECK(backend.AcquireNextImage(1000000, &imageIndex, {}) == NOS_RESULT_TIMEOUT);
+	backend.SetStalled(false);
+	NOS_CHECK(backend.AcquireNextImage(1000000, &imageIndex, {}) == NOS_RESULT_SUCCESS);
+}
+
+NOS_TEST(OutOfDateSwapchainIsRecreated)
+{
+	NullPresentBackend backend;
+	backend.CreateSurface(nullptr);
+	PresentSwapchain swapchain;
+	NOS_CHECK(swapchain.Create(backend, { 1920, 1080 }, NOS_PRESENT_MODE_FIFO, 2));
+	uint32_t imageIndex = 0;
+	backend.AcquireNextImage(0, &imageIndex, {});
+	backend.MarkOutOfDate();
+	NOS_CHECK(backend.Present(imageIndex, {}) != NOS_RESULT_SUCCESS);
+	// What DisplayOut does on a failed present
+	swapchain.Retire(0);
+	NOS_CHECK(!swapchain.IsCreated() && !backend.HasSwapchain());
+	NOS_CHECK(swapchain.Create(backend, { 2560, 1440 }, NOS_PRESENT_MODE_FIFO, 2));
+	NOS_CHECK(backend.SwapchainsCreated == 2);
+	NOS_CHECK(swapchain.Extent.x == 2560 && swapchain.Images[0].Info.Texture.Width == 2560);
+	backend.AcquireNextImage(0, &imageIndex, {});
+	NOS_CHECK(imageIndex == 0 && backend.Present(imageIndex, {}) == NOS_RESULT_SUCCESS);
+}
+
+NOS_TEST(SwapchainHasSemaphoresPerSlotAndImage)
+{
+	NullPresentBackend backend;
+	backend.CreateSurface(nullptr);
+	PresentSwapchain swapchain;
+	NOS_CHECK(swapchain.Create(backend, { 1920, 1080 }, NOS_PRESENT_MODE_MAILBOX, 4, true));
+	NOS_CHECK(swapchain.GetImageCount() == 3);
+	NOS_CHECK(swapchain.AcquireSemaphores.size() == 4 && swapchain.AcquireAheadSemaphores.size() == 4);
+	NOS_CHECK(swapchain.PresentSemaphores.size() == 3);
+	// Headless images are never submitted, their semaphores go with the swapchain
+	swapchain.Retire(10);
+	NOS_CHECK(!swapchain.HasRetired());
+	NOS_CHECK(swapchain.AcquireSemaphores.empty() && swapchain.PresentSemaphores.empty());
+	// Retiring without a swapchain does nothing
+	swapchain.Retire(11);
+	NOS_CHECK(!swapchain.HasRetired());
+}
+
+namespace
+{
+// Keeps retired swapchains like the Vulkan backend does, their handles are only counted
+struct RetainingPresentBackend : NullPresentBackend
+{
+	nosSwapchainHandle RetireSwapchain() override
+	{
+		NullPresentBackend::RetireSwapchain();
+		return reinterpret_cast<nosSwapchainHandle>(uintptr_t(++Retired));
+	}
+	void DestroyRetiredSwapchain(nosSwapchainHandle& swapchain) override
+	{
+		if (swapchain)
+			++Destroyed;
+		swapchain = {};
+	}
+	bool IsHeadless() const override { return false; }
+
+	uint32_t Retired = 0;
+	uint32_t Destroyed = 0;
+};
+}
+
+NOS_TEST(RetiredSwapchainOutlivesItsFrames)
+{
+	RetainingPresentBackend backend;
+	backend.CreateSurface(nullptr);
+	PresentSwapchain swapchain;
+	NOS_CHECK(swapchain.Create(backend, { 1920, 1080 }, NOS_PRESENT_MODE_FIFO, 2));
+	// Frames up to 5 may still present to it, a new swapchain is created right away
+	swapchain.Retire(5);
+	NOS_CHECK(!backend.HasSwapchain() && swapchain.HasRetired() && backend.Destroyed == 0);
+	NOS_CHECK(swapchain.Create(backend, { 2560, 1440 }, NOS_PRESENT_MODE_FIFO, 2));
+	swapchain.ReleaseRetired(4);
+	NOS_CHECK(swapchain.HasRetired() && backend.Destroyed == 0);
+	swapchain.ReleaseRetired(5);
+	NOS_CHECK(!swapchain.HasRetired() && backend.Destroyed == 1);
+	// Teardown releases what is left after a queue flush
+	swapchain.Retire(9);
+	swapchain.ReleaseAllRetired();
+	NOS_CHECK(!swapchain.HasRetired() && backend.Retired == 2 && backend.Destroyed == 2);
+}
@@ -0,0 +1,122 @@
+#include "FramePacer.h"
+#include "FrameStats.h"
+#include "MockCustomResolution.h"
+#include "PresentSwapchain.h"
+#include "Test.h"
+
+#include <cstdlib>
+
+// Per-frame, swapchain recreation and monitor enumeration cost of the DisplayOut present path, on NullPresentBackend
+// and the mock custom resolution backend so that it runs without a GPU or a display. The GPU work of a frame is not
+// part of it: headless images are never submitted.
+//     PresentBenchmark [frames]
+
+using namespace nos::display;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t FramesInFlight = 2;
+constexpr uint32_t DisplayCount = 8;
+
+// Mean over every iteration, percentiles over the last ones like the latency pins of DisplayOut
+void Report(const char* name, uint64_t iterations, Clock::duration total, LatencySummary summary)
+{
+	double mean = std::chrono::duration<double, std::micro>(total).count() / std::max<uint64_t>(iterations, 1);
+	std::printf("%-20s %10llu iterations  mean %9.3f us  p50 %9.3f us  p99 %9.3f us  max %9.3f us\n", name, (unsigned long long)iterations, mean,
+				summary.P50 * 1000.0f, summary.P99 * 1000.0f, summary.Max * 1000.0f);
+}
+
+// The headless part of DisplayOut's ExecuteNode: acquire, present and the bookkeeping around them
+bool BenchmarkFrames(uint64_t frames)
+{
+	NullPresentBackend backend;
+	backend.CreateSurface(nullptr);
+	PresentSwapchain swapchain;
+	if (!swapchain.Create(backend, { 3840, 2160 }, NOS_PRESENT_MODE_MAILBOX, FramesInFlight, true))
+		return false;
+	FramePacer pacer(SteadyPacingClock::Get());
+	PresentStageStats stats;
+	uint32_t currentFrame = 0;
+	auto start = Clock::now();
+	for (uint64_t frame = 0; frame < frames; ++frame)
+	{
+		auto frameStart = Clock::now();
+		pacer.MarkFrame();
+		uint32_t imageIndex;
+		if (backend.AcquireNextImage(0, &imageIndex, swapchain.AcquireSemaphores[currentFrame]) != NOS_RESULT_SUCCESS)
+			return false;
+		auto acquired = Clock::now();
+		stats.Add(PresentStage::Acquire, acquired - frameStart);
+		if (backend.Present(imageIndex, swapchain.PresentSemaphores[imageIndex]) != NOS_RESULT_SUCCESS)
+			return false;
+		currentFrame = (currentFrame + 1) % FramesInFlight;
+		swapchain.ReleaseRetired(frame);
+		auto presented = Clock::now();
+		stats.Add(PresentStage::Present, presented - acquired);
+		stats.Add(PresentStage::Frame, presented - frameStart);
+	}
+	Report("Frame", frames, Clock::now() - start, stats.Summarize(PresentStage::Frame));
+	return backend.FramesPresented == frames;
+}
+
+// A resize: the swapchain is retired and created again at the new extent
+bool BenchmarkRecreation(uint64_t recreations)
+{
+	NullPresentBackend backend;
+	backend.CreateSurface(nullptr);
+	PresentSwapchain swapchain;
+	PresentStageStats stats;
+	auto start = Clock::now();
+	for (uint64_t i = 0; i < recreations; ++i)
+	{
+		auto recreateStart = Clock::now();
+		swapchain.Retire(i);
+		if (!swapchain.Create(backend, { 1920 + uint32_t(i % 2), 1080 }, NOS_PRESENT_MODE_MAILBOX, FramesInFlight, true))
+			return false;
+		stats.Add(PresentStage::SwapchainRecreate, Clock::now() - recreateStart);
+	}
+	Report("Recreate", recreations, Clock::now() - start, stats.Summarize(PresentStage::SwapchainRecreate));
+	return backend.SwapchainsCreated == recreations && !swapchain.HasRetired();
+}
+
+// A hot-plug: the topology is rebuilt and the EDID of every display read and parsed again
+bool BenchmarkEnumeration(uint64_t enumerations)
+{
+	test::MockCustomResolution backend(DisplayCount);
+	std::vector<WindowSystemMonitor> monitors;
+	for (uint32_t i = 0; i < DisplayCount; ++i)
+		monitors.push_back({ .AdapterName = "Mock-" + std::to_string(i), .Handle = reinterpret_cast<void*>(uintptr_t(i + 1)), .Name = "Mock" });
+	PresentStageStats stats;
+	auto start = Clock::now();
+	for (uint64_t i = 0; i < enumerations; ++i)
+	{
+		auto enumerationStart = Clock::now();
+		backend.RefreshTopology(monitors);
+		for (auto port : backend.GetActivePortIds())
+			if (!backend.GetCapabilities(port))
+				return false;
+		stats.Add(PresentStage::MonitorEnumeration, Clock::now() - enumerationStart);
+	}
+	Report("MonitorEnumeration", enumerations, Clock::now() - start, stats.Summarize(PresentStage::MonitorEnumeration));
+	return backend.GetTopology()->Entries.size() == DisplayCount;
+}
+}
+
+int main(int argc, char** argv)
+{
+	nos::display::test::SetUpEngine(false);
+	uint64_t frames = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+	if (!frames)
+	{
+		std::printf("Usage: %s [frames]\n", argv[0]);
+		return 2;
+	}
+	bool ok = BenchmarkFrames(frames);
+	ok &= BenchmarkRecreation(std::max<uint64_t>(frames / 100, 1));
+	ok &= BenchmarkEnumeration(std::max<uint64_t>(frames / 1000, 1));
+	if (!ok)
+		std::printf("The present path misbehaved, the numbers above are not meaningful\n");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+#include "PresentPass.h"
+#include "Test.h"
+
+using namespace nos::display;
+
+// Only the placement maths and what RecordPresentPass records are tested. There is no Vulkan device here, so the shader
+// that draws the pass, Shaders/DisplayOutPresent.frag, is neither compiled nor run by these tests.
+
+namespace
+{
+// Stands in for the Vulkan subsystem while a present pass is registered and recorded, nothing reaches a GPU
+struct RecordedPresent
+{
+	uint32_t Copies = 0;
+	uint32_t Passes = 0;
+	uint32_t BindingCount = 0;
+};
+RecordedPresent Recorded;
+
+nosResult Register(nosResult result)
+{
+	static nosResult Result;
+	Result = result;
+	nosModuleInfo module{};
+	module.RootFolderPath = ".";
+	nosEngine.Module = &module;
+	nosVulkanSubsystem vulkan{};
+	vulkan.RegisterShaders = [](auto...) { return Result; };
+	vulkan.RegisterPasses = [](auto...) { return Result; };
+	nosVulkan = &vulkan;
+	auto registered = RegisterPresentPass();
+	nosVulkan = nullptr;
+	nosEngine.Module = nullptr;
+	return registered;
+}
+
+RecordedPresent Record(nosResourceShareInfo const& input, nosResourceShareInfo const& output, PresentPassSettings const& settings,
+					   bool registered = true)
+{
+	Register(registered ? NOS_RESULT_SUCCESS : NOS_RESULT_FAILED);
+	nosVulkanSubsystem vulkan{};
+	vulkan.Copy = [](auto...) {
+		++Recorded.Copies;
+		return NOS_RESULT_SUCCESS;
+	};
+	vulkan.RunPass = [](auto, auto* pass) {
+		++Recorded.Passes;
+		Recorded.BindingCount = pass->BindingCount;
+		return NOS_RESULT_SUCCESS;
+	};
+	Recorded = {};
+	nosVulkan = &vulkan;
+	RecordPresentPass(nullptr, input, output, settings);
+	nosVulkan = nullptr;
+	return Recorded;
+}
+
+nosResourceShareInfo Texture(uint32_t width, uint32_t height, nosFormat format = NOS_FORMAT_B8G8R8A8_UNORM)
+{
+	nosResourceShareInfo texture{};
+	texture.Info.Texture.Width = width;
+	texture.Info.Texture.Height = height;
+	texture.Info.Texture.Format = format;
+	return texture;
+}
+}
+
+NOS_TEST(ParsesPinNames)
+{
+	NOS_CHECK(ParsePresentScaleMode("Integer") == PresentScaleMode::Integer);
+	NOS_CHECK(!ParsePresentScaleMode("Bicubic"));
+	NOS_CHECK(ParsePresentRotation("270") == PresentRotation::Rotate270);
+	NOS_CHECK(!ParsePresentRotation("45"));
+}
+
+NOS_TEST(StretchFillsTheOutput)
+{
+	NOS_CHECK((ComputePresentRect({ 1920, 1080 }, { 1280, 1024 }, PresentScaleMode::Bilinear, false) == PresentRect{ 0, 0, 1280, 1024 }));
+	NOS_CHECK((ComputePresentRect({ 1920, 1080 }, { 1280, 1024 }, PresentScaleMode::Nearest, false) == PresentRect{ 0, 0, 1280, 1024 }));
+	// Without an input there is nothing to keep the aspect of
+	NOS_CHECK((ComputePresentRect({ 0, 0 }, { 1280, 1024 }, PresentScaleMode::Bilinear, true) == PresentRect{ 0, 0, 1280, 1024 }));
+}
+
+NOS_TEST(LetterboxKeepsTheAspectCentered)
+{
+	NOS_CHECK((ComputePresentRect({ 1920, 1080 }, { 1920, 1200 }, PresentScaleMode::Bilinear, true) == PresentRect{ 0, 60, 1920, 1080 }));
+	NOS_CHECK((ComputePresentRect({ 1440, 1080 }, { 1920, 1080 }, PresentScaleMode::Bilinear, true) == PresentRect{ 240, 0, 1440, 1080 }));
+	NOS_CHECK((ComputePresentRect({ 3840, 2160 }, { 1280, 1024 }, PresentScaleMode::Nearest, true) == PresentRect{ 0, 152, 1280, 720 }));
+}
+
+NOS_TEST(IntegerScaleUsesWholeFactors)
+{
+	// x3, the largest factor that fits
+	NOS_CHECK((ComputePresentRect({ 640, 360 }, { 1920, 1200 }, PresentScaleMode::Integer, false) == PresentRect{ 0, 60, 1920, 1080 }));
+	// x1.8 fits, so it stays at x1
+	NOS_CHECK((ComputePresentRect({ 800, 600 }, { 1920, 1080 }, PresentScaleMode::Integer, false) == PresentRect{ 560, 240, 800, 600 }));
+	// Shrinking divides by whole numbers: 1/2, then 1/3 where 1/2 does not fit
+	NOS_CHECK((ComputePresentRect({ 3840, 2160 }, { 1920, 1200 }, PresentScaleMode::Integer, false) == PresentRect{ 0, 60, 1920, 1080 }));
+	NOS_CHECK((ComputePresentRect({ 4000, 2000 }, { 1920, 1080 }, PresentScaleMode::Integer, false) == PresentRect{ 293, 206, 1333, 667 }));
+}
+
+NOS_TEST(RotationSwapsTheExtent)
+{
+	NOS_CHECK(GetRotatedExtent({ 1080, 1920 }, PresentRotation::Rotate90).x == 1920);
+	NOS_CHECK(GetRotatedExtent({ 1080, 1920 }, PresentRotation::Rotate270).y == 1080);
+	NOS_CHECK(GetRotatedExtent({ 1080, 1920 }, PresentRotation::Rotate180).x == 1080);
+	// A portrait input turned onto a landscape output fills it
+	auto rotated = GetRotatedExtent({ 1080, 1920 }, PresentRotation::Rotate90);
+	NOS_CHECK((ComputePresentRect(rotated, { 1920, 1080 }, PresentScaleMode::Bilinear, true) == PresentRect{ 0, 0, 1920, 1080 }));
+}
+
+NOS_TEST(SourceRectIsClampedToTheInput)
+{
+	NOS_CHECK((ClampSourceRect({ 100, 50, 800, 600 }, { 1920, 1080 }) == PresentRect{ 100, 50, 800, 600 }));
+	NOS_CHECK((ClampSourceRect({ -10, -10, 100, 100 }, { 50, 50 }) == PresentRect{ 0, 0, 50, 50 }));
+	NOS_CHECK((ClampSourceRect({ 1800, 1000, 400, 400 }, { 1920, 1080 }) == PresentRect{ 1800, 1000, 120, 80 }));
+	NOS_CHECK(ClampSourceRect({ 2000, 0, 100, 100 }, { 1920, 1080 }).IsEmpty());
+}
+
+NOS_TEST(MatchingInputIsCopied)
+{
+	auto recorded = Record(Texture(1920, 1080), Texture(1920, 1080), {});
+	NOS_CHECK(recorded.Copies == 1 && recorded.Passes == 0);
+	// A crop of the whole input is no crop
+	PresentPassSettings wholeInput;
+	wholeInput.SourceRect = { 0, 0, 1920, 1080 };
+	recorded = Record(Texture(1920, 1080), Texture(1920, 1080), wholeInput);
+	NOS_CHECK(recorded.Copies == 1 && recorded.Passes == 0);
+}
+
+NOS_TEST(EverythingElseIsOneDraw)
+{
+	auto isDraw = [](RecordedPresent const& recorded) { return recorded.Copies == 0 && recorded.Passes == 1 && recorded.BindingCount > 0; };
+	NOS_CHECK(isDraw(Record(Texture(1280, 720), Texture(1920, 1080), {})));
+	NOS_CHECK(isDraw(Record(Texture(1920, 1080, NOS_FORMAT_R16G16B16A16_SFLOAT), Texture(1920, 1080), {})));
+	PresentPassSettings transforms[5];
+	transforms[0].SourceRect = { 0, 0, 960, 540 };
+	transforms[1].Rotation = PresentRotation::Rotate180;
+	transforms[2].FlipHorizontal = true;
+	transforms[3].FlipVertical = true;
+	transforms[4].OffsetX = 8;
+	for (auto& settings : transforms)
+	{
+		NOS_CHECK(settings.HasTransform());
+		NOS_CHECK(isDraw(Record(Texture(1920, 1080), Texture(1920, 1080), settings)));
+	}
+	NOS_CHECK(!PresentPassSettings{}.HasTransform());
+}
+
+NOS_TEST(WithoutTheRegisteredPassEverythingIsCopied)
+{
+	NOS_CHECK(Register(NOS_RESULT_FAILED) != NOS_RESULT_SUCCESS);
+	NOS_CHECK(Register(NOS_RESULT_SUCCESS) == NOS_RESULT_SUCCESS);
+	auto isCopy = [](RecordedPresent const& recorded) { return recorded.Copies == 1 && recorded.Passes == 0; };
+	NOS_CHECK(isCopy(Record(Texture(1280, 720), Texture(1920, 1080), {}, false)));
+	NOS_CHECK(isCopy(Record(Texture(1920, 1080, NOS_FORMAT_R16G16B16A16_SFLOAT), Texture(1920, 1080), {}, false)));
+	PresentPassSettings rotated;
+	rotated.Rotation = PresentRotation::Rotate90;
+	NOS_CHECK(isCopy(Record(Texture(1920, 1080), Texture(1920, 1080), rotated, false)));
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+// Minimal test registry. Every test executable links TestMain.cpp, which runs the NOS_TESTs of the binary, or only the
+// ones named on the command line, and fails if any check failed. A binary whose tests were all skipped exits with
+// SkipExitCode, CTest reports it as skipped.
+namespace nos::display::test
+{
+struct TestCase
+{
+	const char* Name;
+	void (*Run)();
+};
+
+std::vector<TestCase>& GetTests();
+
+struct TestRegistrar
+{
+	TestRegistrar(const char* name, void (*run)()) { GetTests().push_back({ name, run }); }
+};
+
+inline constexpr int SkipExitCode = 77;
+
+// Points the engine's logging at stdout, informational messages are dropped unless logInfo is set
+void SetUpEngine(bool logInfo);
+
+// Records the failed check and continues the test
+void Fail(const char* file, int line, const char* expression);
+// Marks the running test skipped, for tests that need something the machine does not have
+void Skip(const char* reason);
+}
+
+#define NOS_TEST(name)                                                              \
+	static void name();                                                             \
+	static nos::display::test::TestRegistrar name##Registrar(#name, name);          \
+	static void name()
+
+#define NOS_CHECK(expression)                                                       \
+	do                                                                              \
+	{                                                                               \
+		if (!(expression))                                                          \
+			nos::display::test::Fail(__FILE__, __LINE__, #expression);              \
+	} while (0)
+
+#define NOS_SKIP(reason)                                                            \
+	do                                                                              \
+	{                                                                               \
+		nos::display::test::Skip(reason);                                           \
+		return;                                                                     \
+	} while (0)
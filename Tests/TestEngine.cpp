@@ -0,0 +1,36 @@
+#include "Test.h"
+
+#include <Nodos/PluginHelpers.hpp>
+#include <nosVulkanSubsystem/nosVulkanSubsystem.h>
+
+#include <cstdarg>
+
+// Set up by the engine when the plugin is loaded. The tested modules only log through it and never reach the GPU.
+nosEngineServices nosEngine{};
+nosVulkanSubsystem* nosVulkan = nullptr;
+
+namespace nos::display::test
+{
+namespace
+{
+void Log(const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	std::vprintf(format, args);
+	va_end(args);
+	std::putchar('\n');
+}
+
+void Discard(const char*, ...)
+{
+}
+}
+
+void SetUpEngine(bool logInfo)
+{
+	nosEngine.LogI = logInfo ? Log : Discard;
+	nosEngine.LogW = Log;
+	nosEngine.LogE = Log;
+}
+}
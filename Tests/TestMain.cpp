@@ -0,0 +1,57 @@
+#include "Test.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace nos::display::test
+{
+namespace
+{
+uint32_t FailedChecks = 0;
+bool Skipped = false;
+}
+
+std::vector<TestCase>& GetTests()
+{
+	static std::vector<TestCase> tests;
+	return tests;
+}
+
+void Fail(const char* file, int line, const char* expression)
+{
+	++FailedChecks;
+	std::printf("%s:%d: check failed: %s\n", file, line, expression);
+}
+
+void Skip(const char* reason)
+{
+	Skipped = true;
+	std::printf("Skipped: %s\n", reason);
+}
+}
+
+int main(int argc, char** argv)
+{
+	using namespace nos::display::test;
+	SetUpEngine(true);
+	uint32_t failedTests = 0;
+	uint32_t ranTests = 0;
+	for (auto& test : GetTests())
+	{
+		bool selected = argc < 2;
+		for (int i = 1; i < argc; ++i)
+			selected |= std::strcmp(argv[i], test.Name) == 0;
+		if (!selected)
+			continue;
+		auto checksBefore = FailedChecks;
+		Skipped = false;
+		test.Run();
+		bool passed = FailedChecks == checksBefore;
+		failedTests += !passed;
+		ranTests += !passed || !Skipped;
+		std::printf("[%s] %s\n", !passed ? "FAIL" : Skipped ? "SKIP" : "PASS", test.Name);
+	}
+	if (failedTests)
+		return 1;
+	return ranTests ? 0 : SkipExitCode;
+}
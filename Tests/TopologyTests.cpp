@@ -0,0 +1,109 @@
+#include "MockCustomResolution.h"
+#include "Test.h"
+
+using namespace nos::display;
+using namespace nos::display::test;
+
+namespace
+{
+void* Handle(uintptr_t monitor)
+{
+	return reinterpret_cast<void*>(monitor);
+}
+}
+
+NOS_TEST(TopologyListsActiveDisplays)
+{
+	MockCustomResolution mock(3);
+	auto P = MockCustomResolution::Port;
+	NOS_CHECK((mock.GetActivePortIds() == std::vector{ P(0), P(1), P(2) }));
+	auto topology = mock.GetTopology();
+	NOS_CHECK(topology->Generation == mock.GetTopologyGeneration());
+	for (uint32_t port = 0; port < 3; ++port)
+	{
+		auto entry = topology->FindByPort(P(port));
+		NOS_CHECK(entry && entry->DisplayId == port && !entry->Monitor);
+		NOS_CHECK(topology->FindByDisplayId(port) == entry);
+		NOS_CHECK(entry && topology->FindByKey(entry->Key) == entry);
+		// The port alone is enough while no other GPU has the same port id
+		NOS_CHECK(topology->FindByKey({ .GPUBusId = MonitorKey::AnyGPU, .PortId = port }) == entry);
+	}
+	NOS_CHECK(!topology->FindByPort(P(3)));
+	NOS_CHECK(!mock.GetAdapterName(P(0)));
+}
+
+NOS_TEST(WindowSystemMonitorsAreMatchedByAdapterName)
+{
+	MockCustomResolution mock(3);
+	auto P = MockCustomResolution::Port;
+	mock.RefreshTopology({ { "Mock-1", Handle(0x10), "Left" }, { "Mock-2", Handle(0x20), "Right" }, { "Elsewhere-0", Handle(0x30), "Stray" } });
+	auto topology = mock.GetTopology();
+	NOS_CHECK(topology->Entries.size() == 3);
+	NOS_CHECK(mock.GetAdapterName(P(1)) == "Mock-1");
+	NOS_CHECK(mock.GetGPUPortIdFromAdapterName("Mock-2") == P(2));
+	NOS_CHECK(!mock.GetGPUPortIdFromAdapterName("Elsewhere-0"));
+	auto left = topology->FindByMonitor(Handle(0x10));
+	NOS_CHECK(left && left->Port == P(1) && left->MonitorName == "Left");
+	NOS_CHECK(left && std::string_view(left->Label.data()).starts_with("Left"));
+	NOS_CHECK(!topology->FindByMonitor(Handle(0x30)));
+	// A display the window system does not see keeps its port
+	auto hidden = topology->FindByPort(P(0));
+	NOS_CHECK(hidden && !hidden->Monitor && hidden->AdapterName.empty());
+}
+
+NOS_TEST(HotPlugBumpsTheGenerationAndDropsRemovedDisplays)
+{
+	MockCustomResolution mock(3);
+	auto P = MockCustomResolution::Port;
+	mock.RefreshTopology({ { "Mock-2", Handle(0x20), "Right" } });
+	auto before = mock.GetTopology();
+	auto generation = mock.GetTopologyGeneration();
+	// Unplug the display on port 2
+	mock.DisplayCount = 2;
+	NOS_CHECK(mock.GetTopologyGeneration() == generation);
+	mock.RefreshTopology({});
+	NOS_CHECK(mock.GetTopologyGeneration() == generation + 1);
+	auto after = mock.GetTopology();
+	NOS_CHECK(after->Generation == generation + 1);
+	NOS_CHECK(!after->FindByPort(P(2)) && !after->FindByAdapterName("Mock-2"));
+	NOS_CHECK((mock.GetActivePortIds() == std::vector{ P(0), P(1) }));
+	// Snapshots already handed out do not change under their holders
+	NOS_CHECK(before->Entries.size() == 3 && before->FindByAdapterName("Mock-2"));
+	// And plug it back
+	mock.DisplayCount = 3;
+	mock.RefreshTopology({ { "Mock-2", Handle(0x40), "Right" } });
+	NOS_CHECK(mock.GetTopologyGeneration() == generation + 2);
+	NOS_CHECK(mock.GetGPUPortIdFromAdapterName("Mock-2") == P(2));
+}
+
+NOS_TEST(CapabilitiesAreReadOncePerTopology)
+{
+	MockCustomResolution mock(2);
+	auto P = MockCustomResolution::Port;
+	auto reads = mock.EDIDReads;
+	auto capabilities = mock.GetCapabilities(P(0));
+	NOS_CHECK(capabilities && capabilities->ProductCode == 0);
+	NOS_CHECK(mock.GetCapabilities(P(0)) == capabilities);
+	NOS_CHECK(mock.EDIDReads == reads + 1);
+	NOS_CHECK(mock.GetCapabilities(P(1)) && mock.EDIDReads == reads + 2);
+	mock.RefreshTopology({});
+	NOS_CHECK(mock.GetCapabilities(P(0)) && mock.EDIDReads == reads + 3);
+	// Ports without a display have no capabilities
+	NOS_CHECK(!mock.GetCapabilities(P(5)));
+}
+
+NOS_TEST(HotPlugOfAnotherDisplayOnAPortIsSeen)
+{
+	MockCustomResolution mock(1);
+	auto P = MockCustomResolution::Port;
+	mock.SerialNumbers[0] = 1;
+	auto first = mock.GetCapabilities(P(0));
+	NOS_CHECK(first && first->SerialNumber == 1);
+	mock.SerialNumbers[0] = 2;
+	// Until the hot-plug is reported the cached capabilities are served
+	NOS_CHECK(mock.GetCapabilities(P(0)) == first);
+	mock.RefreshTopology({});
+	auto second = mock.GetCapabilities(P(0));
+	NOS_CHECK(second && second->SerialNumber == 2);
+	NOS_CHECK(first->SerialNumber == 1);
+}
@@ -0,0 +1,55 @@
+#include "VideoWall.h"
+#include "Test.h"
+
+using namespace nos::display;
+
+namespace
+{
+WallTile Tile(uint32_t width, uint32_t height, PresentRotation rotation = PresentRotation::None)
+{
+	return { .Extent = { width, height }, .Rotation = rotation };
+}
+}
+
+NOS_TEST(TwoByTwoWallSkipsTheBezels)
+{
+	std::vector<WallTile> tiles(4, Tile(1920, 1080));
+	auto rects = ComputeWallLayout(tiles, 2, { 20, 30 });
+	NOS_CHECK(rects.size() == 4);
+	NOS_CHECK((rects[0] == PresentRect{ 0, 0, 1920, 1080 }));
+	NOS_CHECK((rects[1] == PresentRect{ 1940, 0, 1920, 1080 }));
+	NOS_CHECK((rects[2] == PresentRect{ 0, 1110, 1920, 1080 }));
+	NOS_CHECK((rects[3] == PresentRect{ 1940, 1110, 1920, 1080 }));
+}
+
+NOS_TEST(RotatedTileWidensItsColumnAndRow)
+{
+	std::vector<WallTile> tiles(4, Tile(1920, 1080));
+	tiles[1].Rotation = PresentRotation::Rotate90;
+	auto rects = ComputeWallLayout(tiles, 2, { 20, 30 });
+	// The portrait tile shows a 1080x1920 part of the canvas, the first row is as tall as it
+	NOS_CHECK((rects[1] == PresentRect{ 1940, 0, 1080, 1920 }));
+	NOS_CHECK((rects[2] == PresentRect{ 0, 1950, 1920, 1080 }));
+	NOS_CHECK((rects[3] == PresentRect{ 1940, 1950, 1920, 1080 }));
+}
+
+NOS_TEST(OffsetsOnlyMoveTheirTile)
+{
+	std::vector<WallTile> tiles(3, Tile(1280, 720));
+	tiles[1].Offset = { -5, 8 };
+	auto rects = ComputeWallLayout(tiles, 3, {});
+	NOS_CHECK((rects[0] == PresentRect{ 0, 0, 1280, 720 }));
+	NOS_CHECK((rects[1] == PresentRect{ 1275, 8, 1280, 720 }));
+	NOS_CHECK((rects[2] == PresentRect{ 2560, 0, 1280, 720 }));
+}
+
+NOS_TEST(IncompleteLastRow)
+{
+	std::vector<WallTile> tiles(3, Tile(1920, 1080));
+	// Zero columns is a single column
+	NOS_CHECK((ComputeWallLayout(tiles, 0, {})[2] == PresentRect{ 0, 2160, 1920, 1080 }));
+	auto rects = ComputeWallLayout(tiles, 2, { 10, 10 });
+	NOS_CHECK(rects.size() == 3);
+	NOS_CHECK((rects[2] == PresentRect{ 0, 1090, 1920, 1080 }));
+	NOS_CHECK(ComputeWallLayout({}, 2, {}).empty());
+}
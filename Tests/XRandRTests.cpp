@@ -0,0 +1,212 @@
+#include "CustomResolutionBase.h"
+#include "Test.h"
+
+#include <cstdlib>
+
+#include <xcb/xcb.h>
+#include <xcb/randr.h>
+
+namespace nos::display
+{
+std::unique_ptr<CustomResolutionBase> TryCreateXRandRCustomResolution();
+}
+
+using namespace nos::display;
+
+namespace
+{
+// The backend switches the modes of real displays just the same, only the Xvfb that CTest starts is used
+bool IsUnderXvfb()
+{
+	return std::getenv("NOSDISPLAY_TEST_XVFB");
+}
+
+std::unique_ptr<CustomResolutionBase> CreateOnXvfb()
+{
+	auto backend = TryCreateXRandRCustomResolution();
+	if (!backend || !backend->Init())
+		return nullptr;
+	backend->RefreshTopology({});
+	return backend;
+}
+
+// What the server reports for the CRTC driving an output, asked over a connection of the test's own
+struct CrtcState
+{
+	nosVec2u Size{};
+	uint32_t DotClock = 0;
+	uint32_t ModeCount = 0; // Modes of the screen
+};
+
+std::optional<CrtcState> QueryCrtc(uint32_t output)
+{
+	auto connection = xcb_connect(nullptr, nullptr);
+	std::optional<CrtcState> state;
+	if (xcb_connection_has_error(connection))
+	{
+		xcb_disconnect(connection);
+		return state;
+	}
+	auto root = xcb_setup_roots_iterator(xcb_get_setup(connection)).data->root;
+	auto resources = xcb_randr_get_screen_resources_current_reply(connection, xcb_randr_get_screen_resources_current(connection, root), nullptr);
+	auto outputInfo = resources ? xcb_randr_get_output_info_reply(connection, xcb_randr_get_output_info(connection, output, resources->config_timestamp), nullptr)
+								: nullptr;
+	auto crtcInfo = outputInfo && outputInfo->crtc
+						? xcb_randr_get_crtc_info_reply(connection, xcb_randr_get_crtc_info(connection, outputInfo->crtc, resources->config_timestamp), nullptr)
+						: nullptr;
+	if (crtcInfo)
+	{
+		state = CrtcState{ .Size = { crtcInfo->width, crtcInfo->height }, .ModeCount = uint32_t(xcb_randr_get_screen_resources_current_modes_length(resources)) };
+		auto modes = xcb_randr_get_screen_resources_current_modes(resources);
+		for (uint32_t i = 0; i < state->ModeCount; ++i)
+			if (modes[i].id == crtcInfo->mode)
+				state->DotClock = modes[i].dot_clock;
+	}
+	std::free(crtcInfo);
+	std::free(outputInfo);
+	std::free(resources);
+	xcb_disconnect(connection);
+	return state;
+}
+
+// Port and RandR output of the Xvfb screen
+std::optional<std::pair<GPUPortIdentifier, uint32_t>> GetScreenOutput(CustomResolutionBase& backend)
+{
+	auto topology = backend.GetTopology();
+	if (topology->Entries.empty())
+		return std::nullopt;
+	return std::pair{ topology->Entries[0].Port, topology->Entries[0].DisplayId };
+}
+
+CustomResolutionInfo Mode(uint32_t width, uint32_t height, float refreshRate)
+{
+	return { .Resolution = { width, height }, .RefreshRate = refreshRate };
+}
+
+constexpr const char* NoXvfb = "needs the Xvfb that CTest starts through xvfb-run";
+}
+
+NOS_TEST(EnumeratesTheXvfbScreen)
+{
+	if (!IsUnderXvfb())
+		NOS_SKIP(NoXvfb);
+	auto backend = CreateOnXvfb();
+	NOS_CHECK(backend);
+	if (!backend)
+		return;
+	// Xvfb has a single output, "screen", connected to a CRTC
+	auto screen = GetScreenOutput(*backend);
+	NOS_CHECK(screen && backend->GetActivePortIds().size() == 1);
+	NOS_CHECK(screen && QueryCrtc(screen->second));
+	// GLFW names monitors after their RandR output
+	backend->RefreshTopology({ { "screen", nullptr, "Xvfb" } });
+	NOS_CHECK(screen && backend->GetGPUPortIdFromAdapterName("screen") == screen->first);
+	backend->Shutdown();
+}
+
+NOS_TEST(AppliesAndRevertsAComputedMode)
+{
+	if (!IsUnderXvfb())
+		NOS_SKIP(NoXvfb);
+	auto backend = CreateOnXvfb();
+	NOS_CHECK(backend);
+	if (!backend)
+		return;
+	auto screen = GetScreenOutput(*backend);
+	NOS_CHECK(screen);
+	if (!screen)
+		return;
+	auto [port, output] = *screen;
+	auto original = QueryCrtc(output);
+	NOS_CHECK(original);
+	if (!original)
+		return;
+	NOS_CHECK(backend->SetResolutionAndRefreshRate(port, Mode(1280, 720, 60)));
+	auto applied = QueryCrtc(output);
+	NOS_CHECK(applied && applied->Size.x == 1280 && applied->Size.y == 720);
+	// Without an EDID, Auto takes the reduced blanking v2 timing
+	NOS_CHECK(applied && applied->DotClock == ComputeCVTReducedBlankingV2Timing(1280, 720, 60)->PixelClock);
+	NOS_CHECK(applied && applied->ModeCount == original->ModeCount + 1);
+	NOS_CHECK(backend->GetAppliedResolution(port));
+
+	NOS_CHECK(backend->RevertResolution(port));
+	auto reverted = QueryCrtc(output);
+	NOS_CHECK(reverted && reverted->Size.x == original->Size.x && reverted->Size.y == original->Size.y);
+	// The created mode is destroyed with the revert
+	NOS_CHECK(reverted && reverted->ModeCount == original->ModeCount);
+	NOS_CHECK(!backend->GetAppliedResolution(port));
+	backend->Shutdown();
+}
+
+NOS_TEST(ReplacedModeIsDestroyed)
+{
+	if (!IsUnderXvfb())
+		NOS_SKIP(NoXvfb);
+	auto backend = CreateOnXvfb();
+	NOS_CHECK(backend);
+	if (!backend)
+		return;
+	auto screen = GetScreenOutput(*backend);
+	NOS_CHECK(screen);
+	if (!screen)
+		return;
+	auto [port, output] = *screen;
+	auto original = QueryCrtc(output);
+	NOS_CHECK(original);
+	if (!original)
+		return;
+	NOS_CHECK(backend->SetResolutionAndRefreshRate(port, Mode(1280, 720, 60)));
+	NOS_CHECK(backend->SetResolutionAndRefreshRate(port, Mode(1024, 768, 60)));
+	auto second = QueryCrtc(output);
+	NOS_CHECK(second && second->Size.x == 1024 && second->Size.y == 768);
+	// The 1280x720 mode went once the CRTC no longer scanned it out, only the 1024x768 one is left
+	NOS_CHECK(second && second->ModeCount == original->ModeCount + 1);
+	NOS_CHECK(second && second->DotClock == ComputeCVTReducedBlankingV2Timing(1024, 768, 60)->PixelClock);
+	NOS_CHECK(backend->RevertResolution(port));
+	auto reverted = QueryCrtc(output);
+	NOS_CHECK(reverted && reverted->ModeCount == original->ModeCount);
+	backend->Shutdown();
+}
+
+NOS_TEST(ShutdownRestoresTheOriginalMode)
+{
+	if (!IsUnderXvfb())
+		NOS_SKIP(NoXvfb);
+	auto backend = CreateOnXvfb();
+	NOS_CHECK(backend);
+	if (!backend)
+		return;
+	auto screen = GetScreenOutput(*backend);
+	NOS_CHECK(screen);
+	if (!screen)
+		return;
+	auto [port, output] = *screen;
+	auto original = QueryCrtc(output);
+	NOS_CHECK(backend->SetResolutionAndRefreshRate(port, Mode(1024, 768, 60)));
+	backend->Shutdown();
+	auto restored = QueryCrtc(output);
+	NOS_CHECK(original && restored && restored->Size.x == original->Size.x && restored->Size.y == original->Size.y);
+}
+
+NOS_TEST(FailedTransactionLeavesTheScreenAlone)
+{
+	if (!IsUnderXvfb())
+		NOS_SKIP(NoXvfb);
+	auto backend = CreateOnXvfb();
+	NOS_CHECK(backend);
+	if (!backend)
+		return;
+	auto screen = GetScreenOutput(*backend);
+	NOS_CHECK(screen);
+	if (!screen)
+		return;
+	auto [port, output] = *screen;
+	auto original = QueryCrtc(output);
+	GPUPortIdentifier missing{ .GPUId = port.GPUId, .PortId = 1000 };
+	NOS_CHECK(!backend->SetResolutionsAndRefreshRates({ { port, Mode(1280, 720, 60) }, { missing, Mode(1280, 720, 60) } }));
+	auto after = QueryCrtc(output);
+	NOS_CHECK(original && after && after->Size.x == original->Size.x && after->Size.y == original->Size.y);
+	NOS_CHECK(after && after->ModeCount == original->ModeCount);
+	NOS_CHECK(!backend->GetAppliedResolution(port));
+	backend->Shutdown();
+}